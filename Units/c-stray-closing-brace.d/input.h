@@ -0,0 +1,23 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#elif 0
+}
+#endif
+
+struct point {
+  int x;
+  int y;
+};
+
+int distance(struct point a, struct point b);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+int after_block(void) { return 0; }
+
+#endif
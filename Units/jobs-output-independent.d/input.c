@@ -0,0 +1,3 @@
+struct { int x; } first;
+union { int y; struct { char c; } inner; } second;
+typedef struct { long z; } third;
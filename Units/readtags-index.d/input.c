@@ -0,0 +1,6 @@
+int alpha;
+int Beta;
+int beta;
+int betamax;
+static void gamma (void) { }
+struct delta { int epsilon; };
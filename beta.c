@@ -303,7 +303,7 @@ static void findBetaTags (void)
 		}
 		endofline:
 		inquote = FALSE;  /* This shouldn't really make a difference */
-	} while (!feof (File.fp));
+	} while (!fileEOF ());
 	vStringDelete (line);
 }
 
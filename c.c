@@ -261,7 +261,17 @@ static langType Lang_vera;
 static vString *Signature;
 static boolean CollectingSignature;
 
-/* Number used to uniquely identify anonymous structs and unions. */
+/*  Which of the values only written as extension fields or extra tags are
+ *  wanted for the current file; those which are not are never built.
+ */
+static struct {
+	boolean signature;    /* function signatures */
+	boolean scope;        /* scope hierarchy of tags */
+	boolean inheritance;  /* parent classes */
+} Want;
+
+/* Number used to uniquely identify anonymous structs and unions within the
+ * current file. */
 static int AnonymousID = 0;
 
 /* Used to index into the CKinds table. */
@@ -1065,6 +1075,8 @@ static void findScopeHierarchy (vString *const string,
 								const statementInfo *const st)
 {
 	vStringClear (string);
+	if (! Want.scope)
+		return;
 	if (isType (st->context, TOKEN_NAME))
 		vStringCopy (string, st->context->name);
 	if (st->parent != NULL)
@@ -1661,6 +1673,8 @@ static void discardTypeList (tokenInfo *const token)
 
 static void addParentClass (statementInfo *const st, tokenInfo *const token)
 {
+	if (! Want.inheritance)
+		return;
 	if (vStringLength (token->name) > 0  &&
 		vStringLength (st->parentClasses) > 0)
 	{
@@ -2113,14 +2127,16 @@ static int parseParens (statementInfo *const st, parenInfo *const info)
 	boolean firstChar = TRUE;
 	int nextChar = '\0';
 
-	CollectingSignature = TRUE;
+	CollectingSignature = Want.signature;
 	vStringClear (Signature);
-	vStringPut (Signature, '(');
+	if (CollectingSignature)
+		vStringPut (Signature, '(');
 	info->parameterCount = 1;
 	do
 	{
 		int c = skipToNonWhite ();
-		vStringPut (Signature, c);
+		if (CollectingSignature)
+			vStringPut (Signature, c);
 
 		switch (c)
 		{
@@ -2156,7 +2172,7 @@ static int parseParens (statementInfo *const st, parenInfo *const info)
 						cppUngetc (c);
 						info->isKnrParamList = FALSE;
 					}
-					else
+					else if (CollectingSignature)
 						vStringCatS (Signature, "..."); /* variable arg list */
 				}
 				break;
@@ -2443,11 +2459,8 @@ static int skipInitializer (statementInfo *const st)
 				if (insideEnumBody (st))
 					done = TRUE;
 				else if (! isBraceFormat ())
-				{
-					verbose ("%s: unexpected closing brace at line %lu\n",
+					verbose ("%s: ignoring unexpected closing brace at line %lu\n",
 							getInputFileName (), getInputLineNumber ());
-					longjmp (Exception, (int) ExceptionBraceFormattingError);
-				}
 				break;
 
 			default: break;
@@ -2777,9 +2790,10 @@ static void createTags (const unsigned int nestLevel,
 				break;
 			else
 			{
-				verbose ("%s: unexpected closing brace at line %lu\n",
+				verbose ("%s: ignoring unexpected closing brace at line %lu\n",
 						getInputFileName (), getInputLineNumber ());
-				longjmp (Exception, (int) ExceptionBraceFormattingError);
+				reinitStatement (st, FALSE);
+				cppEndStatement ();
 			}
 		}
 		else if (isType (token, TOKEN_DOUBLE_COLON))
@@ -2806,7 +2820,15 @@ static rescanReason findCTags (const unsigned int passCount)
 
 	Assert (passCount < 3);
 	cppInit ((boolean) (passCount > 1), isLanguage (Lang_csharp));
+	AnonymousID = 0;
 	Signature = vStringNew ();
+	Want.signature = (boolean) (includeExtensionFields ()  &&
+			Option.extensionFields.signature);
+	Want.scope = (boolean) (Option.include.qualifiedTags  ||
+			(includeExtensionFields ()  &&  (Option.extensionFields.scope  ||
+			 Option.extensionFields.typeRef)));
+	Want.inheritance = (boolean) (includeExtensionFields ()  &&
+			Option.extensionFields.inheritance);
 
 	exception = (exception_t) setjmp (Exception);
 	rescan = RESCAN_NONE;
@@ -42,6 +42,7 @@
 #include "ctags.h"
 #include "entry.h"
 #include "main.h"
+#include "manifest.h"
 #include "options.h"
 #include "read.h"
 #include "routines.h"
@@ -82,10 +83,13 @@ tagFile TagFile = {
     { 0, 0 },           /* numTags */
     { 0, 0, 0 },        /* max */
     { NULL, NULL, 0 },  /* etags */
-    NULL                /* vLine */
+    NULL,               /* vLine */
+    NULL,               /* vRecord */
+    NULL                /* vBatch */
 };
 
 static boolean TagsToStdout = FALSE;
+static long PreviousSize = -1L;  /* size of tag file being updated */
 
 /*
 *   FUNCTION PROTOTYPES
@@ -107,6 +111,8 @@ extern void freeTagFileResources (void)
 	if (TagFile.directory != NULL)
 		eFree (TagFile.directory);
 	vStringDelete (TagFile.vLine);
+	vStringDelete (TagFile.vRecord);
+	vStringDelete (TagFile.vBatch);
 }
 
 extern const char *tagFileName (void)
@@ -381,14 +387,22 @@ extern void openTagFile (void)
 
 	if (TagFile.vLine == NULL)
 		TagFile.vLine = vStringNew ();
+	if (TagFile.vRecord == NULL)
+		TagFile.vRecord = vStringNew ();
+
+	/*  The tags of each source file are kept in memory until it has been
+	 *  parsed successfully, then written out in one go (see commitTagBatch).
+	 */
+	if (TagFile.vBatch == NULL)
+		TagFile.vBatch = vStringNew ();
 
 	/*  Open the tags file.
 	 */
 	if (TagsToStdout)
-		TagFile.fp = tempFile ("w", &TagFile.name);
+		TagFile.fp = stdout;
 	else
 	{
-		boolean fileExists;
+		boolean fileExists, update;
 
 		setDefaultTagFileName ();
 		TagFile.name = eStrdup (Option.tagFileName);
@@ -397,6 +411,8 @@ extern void openTagFile (void)
 			error (FATAL,
 			  "\"%s\" doesn't look like a tag file; I refuse to overwrite it.",
 				  TagFile.name);
+		update = (boolean) (fileExists  &&  Option.incremental  &&
+				readManifest (TagFile.name));
 
 		if (Option.etags)
 		{
@@ -407,12 +423,14 @@ extern void openTagFile (void)
 		}
 		else
 		{
-			if (Option.append  &&  fileExists)
+			if ((Option.append  &&  fileExists)  ||  update)
 			{
 				TagFile.fp = fopen (TagFile.name, "r+");
 				if (TagFile.fp != NULL)
 				{
 					TagFile.numTags.prev = updatePseudoTags (TagFile.fp);
+					if (update)
+						PreviousSize = ftell (TagFile.fp);
 					fclose (TagFile.fp);
 					TagFile.fp = fopen (TagFile.name, "a+");
 				}
@@ -457,22 +475,15 @@ static int replacementTruncate (const char *const name, const long size)
 
 static void sortTagFile (void)
 {
-	if (TagFile.numTags.added > 0L)
+	if (TagFile.numTags.added > 0L  &&  Option.sorted != SO_UNSORTED)
 	{
-		if (Option.sorted != SO_UNSORTED)
-		{
-			verbose ("sorting tag file\n");
+		verbose ("sorting tag file\n");
 #ifdef EXTERNAL_SORT
-			externalSortTags (TagsToStdout);
+		externalSortTags (FALSE);
 #else
-			internalSortTags (TagsToStdout);
+		internalSortTags (FALSE);
 #endif
-		}
-		else if (TagsToStdout)
-			catFile (tagFileName ());
 	}
-	if (TagsToStdout)
-		remove (tagFileName ());  /* remove temporary file */
 }
 
 static void resizeTagFile (const long newSize)
@@ -506,6 +517,53 @@ static void resizeTagFile (const long newSize)
 		fprintf (errout, "Cannot shorten tag file: errno = %d\n", errno);
 }
 
+/*  Drops from the part of the tag file present before this run the tags of
+ *  source files which were either parsed again or not named at all, moving
+ *  the remaining lines down in place.
+ */
+static void removeStaleTags (const long size)
+{
+	FILE *const in = fopen (TagFile.name, "rb");
+	FILE *const out = fopen (TagFile.name, "r+b");
+	unsigned long removed = 0;
+	long newSize;
+
+	if (in == NULL  ||  out == NULL)
+		error (FATAL | PERROR, "cannot update tag file");
+	while (ftell (in) < PreviousSize)
+	{
+		char *const line = readLine (TagFile.vLine, in);
+		char *const tab = (line == NULL) ? NULL : strchr (line, '\t');
+		boolean keep = TRUE;
+
+		if (line == NULL)
+			break;
+		if (strncmp (line, PSEUDO_TAG_PREFIX, strlen (PSEUDO_TAG_PREFIX)) != 0
+				&&  tab != NULL)
+		{
+			char *const end = strchr (tab + 1, '\t');
+			if (end != NULL)
+				*end = '\0';
+			keep = isCurrentTagPath (tab + 1);
+			if (end != NULL)
+				*end = '\t';
+		}
+		if (keep)
+			fputs (line, out);
+		else
+			++removed;
+	}
+	copyBytes (in, out, WHOLE_FILE);
+	newSize = ftell (out);
+	fclose (in);
+	if (fclose (out) != 0)
+		error (FATAL | PERROR, "cannot update tag file");
+	verbose ("removed %lu outdated tag%s\n", removed, removed == 1 ? "" : "s");
+	TagFile.numTags.prev -= removed;
+	if (newSize < size)
+		resizeTagFile (newSize);
+}
+
 static void writeEtagsIncludes (FILE *const fp)
 {
 	if (Option.etagsInclude)
@@ -519,28 +577,141 @@ static void writeEtagsIncludes (FILE *const fp)
 	}
 }
 
-extern void closeTagFile (const boolean resize)
+/*  Writes part of the tags of the current source file into its batch.
+ */
+static void writeTagData (const char *const data, const size_t length)
+{
+	vStringNCatSUnsafe (TagFile.vBatch, data, length);
+}
+
+static void writeTagRecord (const vString *const record)
+{
+	writeTagData (vStringValue (record), vStringLength (record));
+}
+
+/*  Returns whether committed tags are still kept in memory, to be sorted
+ *  before being written to standard output.
+ */
+static boolean isBatchCollected (void)
+{
+	return (boolean) (TagsToStdout  &&  Option.sorted != SO_UNSORTED);
+}
+
+/*  Writes out the tags of the source file just parsed, kept in memory until
+ *  then so that a parser can start over by simply discarding them. Unless
+ *  they must be sorted on their way to standard output, they go straight to
+ *  the tag destination; otherwise they are collected with those of the files
+ *  parsed before, and sorted into a run of their own whenever too many are
+ *  collected.
+ */
+extern void commitTagBatch (void)
 {
-	long desiredSize, size;
+	vString *const batch = TagFile.vBatch;
 
+	if (! isBatchCollected ())
+	{
+		if (fwrite (vStringValue (batch), (size_t) 1, vStringLength (batch),
+					TagFile.fp) < vStringLength (batch))
+			error (FATAL | PERROR, "cannot complete write");
+		vStringClear (batch);
+	}
+	else if (vStringLength (batch) >= (size_t) SORT_BUFFER_SIZE)
+	{
+		spillSortedTags (vStringValue (batch), vStringLength (batch));
+		vStringClear (batch);
+	}
+}
+
+/*  Appends `size' bytes of tag lines read from `fp' to the tag file.
+ */
+extern void copyTagData (FILE *const fp, const long size)
+{
+	if (! isBatchCollected ())
+	{
+		commitTagBatch ();
+		copyBytes (fp, TagFile.fp, size);
+	}
+	else
+	{
+		long remaining = size;
+
+		/*  Pass on whole lines, as sorted runs may be spilled in between.
+		 */
+		while (remaining > 0)
+		{
+			const char *const line = readLine (TagFile.vLine, fp);
+
+			if (line == NULL)
+				break;
+			writeTagData (line, vStringLength (TagFile.vLine));
+			remaining -= (long) vStringLength (TagFile.vLine);
+			commitTagBatch ();
+		}
+	}
+}
+
+/*  Makes committed tags go straight to `fp' from now on, whatever the tag
+ *  destination.
+ */
+extern void redirectTagFile (FILE *const fp)
+{
+	vStringClear (TagFile.vBatch);
+	TagsToStdout = FALSE;
+	TagFile.fp = fp;
+}
+
+/*  Writes out whatever tags are still kept in memory for standard output.
+ */
+static void flushTagBatch (void)
+{
+	vString *const batch = TagFile.vBatch;
+
+	commitTagBatch ();
+	if (Option.sorted != SO_UNSORTED)
+	{
+		if (TagFile.numTags.added > 0L)
+			verbose ("sorting tag file\n");
+		writeSortedTags (vStringValue (batch), vStringLength (batch), stdout);
+		vStringClear (batch);
+	}
+	if (Option.etags)
+		writeEtagsIncludes (stdout);
+	fflush (stdout);
+}
+
+static void closeTagStream (void)
+{
+	long size;
+
+	commitTagBatch ();
 	if (Option.etags)
 		writeEtagsIncludes (TagFile.fp);
-	desiredSize = ftell (TagFile.fp);
 	fseek (TagFile.fp, 0L, SEEK_END);
 	size = ftell (TagFile.fp);
 	fclose (TagFile.fp);
-	if (resize  &&  desiredSize < size)
+	if (PreviousSize >= 0)
 	{
-		DebugStatement (
-			debugPrintf (DEBUG_STATUS, "shrinking %s from %ld to %ld bytes\n",
-				TagFile.name, size, desiredSize); )
-		resizeTagFile (desiredSize);
+		removeStaleTags (size);
+		PreviousSize = -1L;
 	}
 	sortTagFile ();
+	if (Option.incremental)
+	{
+		writeManifest (TagFile.name);
+		freeManifest ();
+	}
 	eFree (TagFile.name);
 	TagFile.name = NULL;
 }
 
+extern void closeTagFile (void)
+{
+	if (TagsToStdout)
+		flushTagBatch ();
+	else
+		closeTagStream ();
+}
+
 extern void beginEtagsFile (void)
 {
 	TagFile.etags.fp = tempFile ("w+b", &TagFile.etags.name);
@@ -549,14 +720,20 @@ extern void beginEtagsFile (void)
 
 extern void endEtagsFile (const char *const name)
 {
+	vString *const record = TagFile.vRecord;
+	char byteCount [24];
 	const char *line;
 
-	fprintf (TagFile.fp, "\f\n%s,%ld\n", name, (long) TagFile.etags.byteCount);
+	sprintf (byteCount, ",%ld\n", (long) TagFile.etags.byteCount);
+	vStringCopyS (record, "\f\n");
+	vStringCatS (record, name);
+	vStringCatS (record, byteCount);
+	writeTagRecord (record);
 	if (TagFile.etags.fp != NULL)
 	{
 		rewind (TagFile.etags.fp);
 		while ((line = readLine (TagFile.vLine, TagFile.etags.fp)) != NULL)
-			fputs (line, TagFile.fp);
+			writeTagData (line, strlen (line));
 		fclose (TagFile.etags.fp);
 		remove (TagFile.etags.name);
 		eFree (TagFile.etags.name);
@@ -569,46 +746,45 @@ extern void endEtagsFile (const char *const name)
  *  Tag entry management
  */
 
-/*  This function copies the current line out to a specified file. It has no
+/*  This function appends the current line to a tag record. It has no
  *  effect on the fileGetc () function.  During copying, any '\' characters
  *  are doubled and a leading '^' or trailing '$' is also quoted. End of line
- *  characters (line feed or carriage return) are dropped.
+ *  characters (line feed or carriage return) are dropped. Runs of characters
+ *  needing no quoting are copied in one go.
  */
-static size_t writeSourceLine (FILE *const fp, const char *const line)
+static void writeSourceLine (vString *const record, const char *const line)
 {
-	size_t length = 0;
-	const char *p;
+	const char *const special = Option.backward ? "\\?$\r\n" : "\\/$\r\n";
+	const char *p = line;
 
 	/*  Write everything up to, but not including, a line end character.
 	 */
-	for (p = line  ;  *p != '\0'  ;  ++p)
+	for (;;)
 	{
-		const int next = *(p + 1);
-		const int c = *p;
+		const size_t span = strcspn (p, special);
+		int c;
 
-		if (c == CRETURN  ||  c == NEWLINE)
+		vStringNCatSUnsafe (record, p, span);
+		p += span;
+		c = *p;
+		if (c == '\0'  ||  c == CRETURN  ||  c == NEWLINE)
 			break;
 
 		/*  If character is '\', or a terminal '$', then quote it.
 		 */
-		if (c == BACKSLASH  ||  c == (Option.backward ? '?' : '/')  ||
-			(c == '$'  &&  (next == NEWLINE  ||  next == CRETURN)))
-		{
-			putc (BACKSLASH, fp);
-			++length;
-		}
-		putc (c, fp);
-		++length;
+		if (c != '$'  ||  *(p + 1) == NEWLINE  ||  *(p + 1) == CRETURN)
+			vStringPut (record, BACKSLASH);
+		vStringPut (record, c);
+		++p;
 	}
-	return length;
 }
 
-/*  Writes "line", stripping leading and duplicate white space.
+/*  Appends "line" to a tag record, stripping leading and duplicate white
+ *  space.
  */
-static size_t writeCompactSourceLine (FILE *const fp, const char *const line)
+static void writeCompactSourceLine (vString *const record, const char *const line)
 {
 	boolean lineStarted = FALSE;
-	size_t  length = 0;
 	const char *p;
 	int c;
 
@@ -630,33 +806,45 @@ static size_t writeCompactSourceLine (FILE *const fp, const char *const line)
 				c = ' ';  /* force space character for any white space */
 			}
 			if (c != CRETURN  ||  *(p + 1) != NEWLINE)
-			{
-				putc (c, fp);
-				++length;
-			}
+				vStringPut (record, c);
 		}
 	}
-	return length;
+}
+
+/*  Appends "s" and a space to a tag record, padding "s" with spaces to at
+ *  least "width" characters.
+ */
+static void writePaddedField (
+		vString *const record, const char *const s, const size_t width)
+{
+	size_t length;
+
+	vStringCatS (record, s);
+	for (length = strlen (s)  ;  length < width  ;  ++length)
+		vStringPut (record, ' ');
+	vStringPut (record, ' ');
 }
 
 static int writeXrefEntry (const tagEntryInfo *const tag)
 {
 	const char *const line =
 			readSourceLine (TagFile.vLine, tag->filePosition, NULL);
-	int length;
-
-	if (Option.tagFileFormat == 1)
-		length = fprintf (TagFile.fp, "%-16s %4lu %-16s ", tag->name,
-				tag->lineNumber, tag->sourceFileName);
-	else
-		length = fprintf (TagFile.fp, "%-16s %-10s %4lu %-16s ", tag->name,
-				tag->kindName, tag->lineNumber, tag->sourceFileName);
-
-	length += writeCompactSourceLine (TagFile.fp, line);
-	putc (NEWLINE, TagFile.fp);
-	++length;
-
-	return length;
+	vString *const record = TagFile.vRecord;
+	char lineNumber [24];
+
+	vStringClear (record);
+	writePaddedField (record, tag->name, 16);
+	if (Option.tagFileFormat != 1)
+		writePaddedField (record,
+				tag->kindName == NULL ? "" : tag->kindName, 10);
+	sprintf (lineNumber, "%4lu", tag->lineNumber);
+	writePaddedField (record, lineNumber, 0);
+	writePaddedField (record, tag->sourceFileName, 16);
+	writeCompactSourceLine (record, line);
+	vStringPut (record, NEWLINE);
+	writeTagRecord (record);
+
+	return (int) vStringLength (record);
 }
 
 /*  Truncates the text line containing the tag at the character following the
@@ -702,75 +890,112 @@ static int writeEtagsEntry (const tagEntryInfo *const tag)
 	return length;
 }
 
-static int addExtensionFields (const tagEntryInfo *const tag)
+static void addExtensionFields (
+		vString *const record, const tagEntryInfo *const tag)
 {
 	const char* const kindKey = Option.extensionFields.kindKey ? "kind:" : "";
 	boolean first = TRUE;
-	const char* separator = ";\"";
-	const char* const empty = "";
-	int length = 0;
-/* "sep" returns a value only the first time it is evaluated */
+	const char* separator = ";\"\t";
+	const char* const empty = "\t";
+/* "sep" returns ";\"" only the first time it is evaluated; both end in a tab */
 #define sep (first ? (first = FALSE, separator) : empty)
 
 	if (tag->kindName != NULL && (Option.extensionFields.kindLong  ||
 		 (Option.extensionFields.kind  && tag->kind == '\0')))
-		length += fprintf (TagFile.fp,"%s\t%s%s", sep, kindKey, tag->kindName);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, kindKey);
+		vStringCatS (record, tag->kindName);
+	}
 	else if (tag->kind != '\0'  && (Option.extensionFields.kind  ||
 			(Option.extensionFields.kindLong  &&  tag->kindName == NULL)))
-		length += fprintf (TagFile.fp, "%s\t%s%c", sep, kindKey, tag->kind);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, kindKey);
+		vStringPut (record, tag->kind);
+	}
 
 	if (Option.extensionFields.lineNumber)
-		length += fprintf (TagFile.fp, "%s\tline:%ld", sep, tag->lineNumber);
+	{
+		char buffer [24];
+		sprintf (buffer, "line:%ld", tag->lineNumber);
+		vStringCatS (record, sep);
+		vStringCatS (record, buffer);
+	}
 
 	if (Option.extensionFields.language  &&  tag->language != NULL)
-		length += fprintf (TagFile.fp, "%s\tlanguage:%s", sep, tag->language);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "language:");
+		vStringCatS (record, tag->language);
+	}
 
 	if (Option.extensionFields.scope  &&
 			tag->extensionFields.scope [0] != NULL  &&
 			tag->extensionFields.scope [1] != NULL)
-		length += fprintf (TagFile.fp, "%s\t%s:%s", sep,
-				tag->extensionFields.scope [0],
-				tag->extensionFields.scope [1]);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, tag->extensionFields.scope [0]);
+		vStringPut (record, ':');
+		vStringCatS (record, tag->extensionFields.scope [1]);
+	}
 
 	if (Option.extensionFields.typeRef  &&
 			tag->extensionFields.typeRef [0] != NULL  &&
 			tag->extensionFields.typeRef [1] != NULL)
-		length += fprintf (TagFile.fp, "%s\ttyperef:%s:%s", sep,
-				tag->extensionFields.typeRef [0],
-				tag->extensionFields.typeRef [1]);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "typeref:");
+		vStringCatS (record, tag->extensionFields.typeRef [0]);
+		vStringPut (record, ':');
+		vStringCatS (record, tag->extensionFields.typeRef [1]);
+	}
 
 	if (Option.extensionFields.fileScope  &&  tag->isFileScope)
-		length += fprintf (TagFile.fp, "%s\tfile:", sep);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "file:");
+	}
 
 	if (Option.extensionFields.inheritance  &&
 			tag->extensionFields.inheritance != NULL)
-		length += fprintf (TagFile.fp, "%s\tinherits:%s", sep,
-				tag->extensionFields.inheritance);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "inherits:");
+		vStringCatS (record, tag->extensionFields.inheritance);
+	}
 
 	if (Option.extensionFields.access  &&  tag->extensionFields.access != NULL)
-		length += fprintf (TagFile.fp, "%s\taccess:%s", sep,
-				tag->extensionFields.access);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "access:");
+		vStringCatS (record, tag->extensionFields.access);
+	}
 
 	if (Option.extensionFields.implementation  &&
 			tag->extensionFields.implementation != NULL)
-		length += fprintf (TagFile.fp, "%s\timplementation:%s", sep,
-				tag->extensionFields.implementation);
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "implementation:");
+		vStringCatS (record, tag->extensionFields.implementation);
+	}
 
 	if (Option.extensionFields.signature  &&
 			tag->extensionFields.signature != NULL)
-		length += fprintf (TagFile.fp, "%s\tsignature:%s", sep,
-				tag->extensionFields.signature);
-
-	return length;
+	{
+		vStringCatS (record, sep);
+		vStringCatS (record, "signature:");
+		vStringCatS (record, tag->extensionFields.signature);
+	}
 #undef sep
 }
 
-static int writePatternEntry (const tagEntryInfo *const tag)
+static void writePatternEntry (
+		vString *const record, const tagEntryInfo *const tag)
 {
 	char *const line = readSourceLine (TagFile.vLine, tag->filePosition, NULL);
 	const int searchChar = Option.backward ? '?' : '/';
 	boolean newlineTerminated;
-	int length = 0;
 
 	if (line == NULL)
 		error (FATAL, "bad tag in %s", vStringValue (File.name));
@@ -778,34 +1003,55 @@ static int writePatternEntry (const tagEntryInfo *const tag)
 		truncateTagLine (line, tag->name, FALSE);
 	newlineTerminated = (boolean) (line [strlen (line) - 1] == '\n');
 
-	length += fprintf (TagFile.fp, "%c^", searchChar);
-	length += writeSourceLine (TagFile.fp, line);
-	length += fprintf (TagFile.fp, "%s%c", newlineTerminated ? "$":"", searchChar);
-
-	return length;
+	vStringPut (record, searchChar);
+	vStringPut (record, '^');
+	writeSourceLine (record, line);
+	if (newlineTerminated)
+		vStringPut (record, '$');
+	vStringPut (record, searchChar);
 }
 
-static int writeLineNumberEntry (const tagEntryInfo *const tag)
+static void writeLineNumberEntry (
+		vString *const record, const tagEntryInfo *const tag)
 {
-	return fprintf (TagFile.fp, "%lu", tag->lineNumber);
+	char buffer [24];
+	sprintf (buffer, "%lu", tag->lineNumber);
+	vStringCatS (record, buffer);
 }
 
+/*  Formats the whole entry into TagFile.vRecord, then writes it at once.
+ */
 static int writeCtagsEntry (const tagEntryInfo *const tag)
 {
-	int length = fprintf (TagFile.fp, "%s\t%s\t",
-		tag->name, tag->sourceFileName);
+	vString *const record = TagFile.vRecord;
+
+	vStringClear (record);
+	vStringCatS (record, tag->name);
+	vStringPut (record, '\t');
+	vStringCatS (record, tag->sourceFileName);
+	vStringPut (record, '\t');
 
 	if (tag->lineNumberEntry)
-		length += writeLineNumberEntry (tag);
+		writeLineNumberEntry (record, tag);
 	else
-		length += writePatternEntry (tag);
+		writePatternEntry (record, tag);
 
 	if (includeExtensionFlags ())
-		length += addExtensionFields (tag);
+		addExtensionFields (record, tag);
 
-	length += fprintf (TagFile.fp, "\n");
+	vStringPut (record, '\n');
+	writeTagRecord (record);
 
-	return length;
+	return (int) vStringLength (record);
+}
+
+/*  Tells whether extension fields are written out at all, so that parsers
+ *  can skip building the values of fields which would be discarded.
+ */
+extern boolean includeExtensionFields (void)
+{
+	return (boolean) (! Option.xref  &&  ! Option.etags  &&
+			includeExtensionFlags ());
 }
 
 extern void makeTagEntry (const tagEntryInfo *const tag)
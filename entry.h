@@ -43,6 +43,8 @@ typedef struct eTagFile {
 		size_t byteCount;
 	} etags;
 	vString *vLine;
+	vString *vRecord;  /* tag entry being formatted */
+	vString *vBatch;   /* tags of current source file, until committed */
 } tagFile;
 
 typedef struct sTagFields {
@@ -92,9 +94,13 @@ extern const char *tagFileName (void);
 extern void copyBytes (FILE* const fromFp, FILE* const toFp, const long size);
 extern void copyFile (const char *const from, const char *const to, const long size);
 extern void openTagFile (void);
-extern void closeTagFile (const boolean resize);
+extern void closeTagFile (void);
+extern void commitTagBatch (void);
+extern void copyTagData (FILE *const fp, const long size);
+extern void redirectTagFile (FILE *const fp);
 extern void beginEtagsFile (void);
 extern void endEtagsFile (const char *const name);
+extern boolean includeExtensionFields (void);
 extern void makeTagEntry (const tagEntryInfo *const tag);
 extern void initTagEntry (tagEntryInfo *const e, const char *const name);
 
@@ -592,6 +592,68 @@ static lineType getLineType (void)
 	return type;
 }
 
+/*  Scans the whole source file for a line which getLineType () would find
+ *  invalid in fixed source form, in which case parsing the file in fixed
+ *  source form is bound to fail. Only the first six columns of each line are
+ *  examined, so this is much cheaper than such a failed parse.
+ */
+static boolean hasInvalidFixedFormLine (void)
+{
+	boolean invalid = FALSE;
+	boolean continued = FALSE;
+	int c = '\0';
+
+	while (! invalid  &&  c != EOF)
+	{
+		boolean label = FALSE;
+		int column;
+
+		if (continued)
+		{
+			/*  This line is the contents of the previous one.
+			 */
+			continued = FALSE;
+			c = skipLine ();
+			continue;
+		}
+		for (column = 0  ;  column < 6  ;  ++column)
+		{
+			c = fileGetc ();
+			if (column == 0  &&  strchr ("*Cc!#$Dd", c) != NULL)
+				break;
+			else if (c == '\t')
+				break;
+			else if (column == 5)
+			{
+				/*  A continuation line ending in column 6 takes the next
+				 *  line as its contents.
+				 */
+				if (c != ' '  &&  c != '0')
+				{
+					invalid = label;
+					continued = (boolean) (c == '\n');
+				}
+				break;
+			}
+			else if (c == ' ')
+				;
+			else if (c == EOF  ||  c == '\n')
+				break;
+			else if (isdigit (c))
+				label = TRUE;
+			else
+			{
+				invalid = TRUE;
+				break;
+			}
+		}
+		if (c != '\n'  &&  c != EOF)
+			c = skipLine ();
+	}
+	fileRewind ();
+	return invalid;
+}
+
 static int getFixedFormChar (void)
 {
 	boolean newline = FALSE;
@@ -2148,6 +2210,12 @@ static rescanReason findFortranTags (const unsigned int passCount)
 	Parent = newToken ();
 	token = newToken ();
 	FreeSourceForm = (boolean) (passCount > 1);
+	if (! FreeSourceForm  &&  hasInvalidFixedFormLine ())
+	{
+		verbose ("%s: not fixed source form; parsing as free source form\n",
+				getInputFileName ());
+		FreeSourceForm = TRUE;
+	}
 	Column = 0;
 	exception = (exception_t) setjmp (Exception);
 	if (exception == ExceptionEOF)
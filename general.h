@@ -53,6 +53,11 @@
 # define HAVE_REGEX 1
 #endif
 
+/* Define to parse files concurrently in worker processes if supported */
+#if defined (HAVE_FORK) && defined (HAVE_WAITPID) && defined (HAVE_PIPE) && defined (HAVE_SYS_WAIT_H)
+# define JOBS_SUPPORTED 1
+#endif
+
 /*  This is a helpful internal feature of later versions (> 2.7) of GCC
  *  to prevent warnings about unused variables.
  */
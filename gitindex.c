@@ -0,0 +1,539 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to read the list of files tracked in a git
+*   working tree from its index (".git/index"), for the --git-index option.
+*   Only the file names, types and sizes are taken from the index; the git
+*   program is not needed. An index whose trailing checksum does not match,
+*   or which depends on an extension not understood here (such as the shared
+*   index of a split index), is not used.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+
+#include "debug.h"
+#include "gitindex.h"
+#include "options.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define INDEX_SIGNATURE     "DIRC"
+#define INDEX_HEADER_SIZE   12
+#define ENTRY_STAT_SIZE     40  /* ctime, mtime, dev, ino, mode, uid, gid, size */
+
+#define FLAG_EXTENDED       0x4000
+#define FLAG_NAME_LENGTH    0x0fff
+#define XFLAG_SKIP_WORKTREE 0x4000
+
+#define MODE_TYPE_MASK      0170000
+#define MODE_FILE           0100000
+#define MODE_LINK           0120000
+#define MODE_GITLINK        0160000
+
+#define EXTENSION_HEADER_SIZE 8  /* signature, size */
+
+#define ROL32(x,n)  ((((x) << (n)) | ((x) >> (32 - (n)))) & 0xffffffffUL)
+#define ROR32(x,n)  ((((x) >> (n)) | ((x) << (32 - (n)))) & 0xffffffffUL)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGitIndex {
+	const unsigned char *buffer;
+	size_t length;            /* not counting the trailing checksum */
+	unsigned long version;
+	unsigned long count;      /* number of entries */
+	size_t hashLength;        /* length of object names */
+} gitIndex;
+
+typedef void (*hashBlockFunction) (unsigned long *const state,
+		const unsigned char *const block);
+
+/*
+*   DATA DEFINITIONS
+*/
+static const unsigned long Sha256Constants [64] = {
+	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
+	0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+	0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
+	0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+	0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+	0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+	0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
+	0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+	0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
+	0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+	0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
+	0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+	0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
+	0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+	0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+	0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static unsigned long readBigEndian (const unsigned char *const p, const int size)
+{
+	unsigned long result = 0;
+	int i;
+	for (i = 0  ;  i < size  ;  ++i)
+		result = (result << 8) | p [i];
+	return result;
+}
+
+/*  Checksums of the index, as git computes them: SHA-1, or SHA-256 in
+ *  repositories using SHA-256 object names.
+ */
+static void sha1Block (unsigned long *const state, const unsigned char *const block)
+{
+	unsigned long w [80];
+	unsigned long a = state [0], b = state [1], c = state [2],
+			d = state [3], e = state [4];
+	int i;
+
+	for (i = 0  ;  i < 16  ;  ++i)
+		w [i] = readBigEndian (block + 4 * i, 4);
+	for (i = 16  ;  i < 80  ;  ++i)
+		w [i] = ROL32 (w [i - 3] ^ w [i - 8] ^ w [i - 14] ^ w [i - 16], 1);
+	for (i = 0  ;  i < 80  ;  ++i)
+	{
+		unsigned long f, k, t;
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5a827999UL;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1UL;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8f1bbcdcUL;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xca62c1d6UL;
+		}
+		t = (ROL32 (a, 5) + (f & 0xffffffffUL) + e + k + w [i]) & 0xffffffffUL;
+		e = d;
+		d = c;
+		c = ROL32 (b, 30);
+		b = a;
+		a = t;
+	}
+	state [0] = (state [0] + a) & 0xffffffffUL;
+	state [1] = (state [1] + b) & 0xffffffffUL;
+	state [2] = (state [2] + c) & 0xffffffffUL;
+	state [3] = (state [3] + d) & 0xffffffffUL;
+	state [4] = (state [4] + e) & 0xffffffffUL;
+}
+
+static void sha256Block (unsigned long *const state, const unsigned char *const block)
+{
+	unsigned long w [64];
+	unsigned long v [8];
+	int i;
+
+	for (i = 0  ;  i < 16  ;  ++i)
+		w [i] = readBigEndian (block + 4 * i, 4);
+	for (i = 16  ;  i < 64  ;  ++i)
+	{
+		const unsigned long s0 = ROR32 (w [i - 15], 7) ^
+				ROR32 (w [i - 15], 18) ^ (w [i - 15] >> 3);
+		const unsigned long s1 = ROR32 (w [i - 2], 17) ^
+				ROR32 (w [i - 2], 19) ^ (w [i - 2] >> 10);
+		w [i] = (w [i - 16] + s0 + w [i - 7] + s1) & 0xffffffffUL;
+	}
+	for (i = 0  ;  i < 8  ;  ++i)
+		v [i] = state [i];
+	for (i = 0  ;  i < 64  ;  ++i)
+	{
+		const unsigned long S1 = ROR32 (v [4], 6) ^ ROR32 (v [4], 11) ^
+				ROR32 (v [4], 25);
+		const unsigned long ch = (v [4] & v [5]) ^ (~v [4] & v [6]);
+		const unsigned long t1 = (v [7] + S1 + ch + Sha256Constants [i] +
+				w [i]) & 0xffffffffUL;
+		const unsigned long S0 = ROR32 (v [0], 2) ^ ROR32 (v [0], 13) ^
+				ROR32 (v [0], 22);
+		const unsigned long maj = (v [0] & v [1]) ^ (v [0] & v [2]) ^
+				(v [1] & v [2]);
+		const unsigned long t2 = (S0 + maj) & 0xffffffffUL;
+		v [7] = v [6];
+		v [6] = v [5];
+		v [5] = v [4];
+		v [4] = (v [3] + t1) & 0xffffffffUL;
+		v [3] = v [2];
+		v [2] = v [1];
+		v [1] = v [0];
+		v [0] = (t1 + t2) & 0xffffffffUL;
+	}
+	for (i = 0  ;  i < 8  ;  ++i)
+		state [i] = (state [i] + v [i]) & 0xffffffffUL;
+}
+
+/*  Pads the message as both SHA-1 and SHA-256 do, feeding it to `block'
+ *  64 bytes at a time, and writes the final state out big-endian.
+ */
+static void hashMessage (
+		const unsigned char *const message, const size_t length,
+		unsigned long *const state, const int stateLength,
+		const hashBlockFunction block, unsigned char *const digest)
+{
+	unsigned char tail [128];
+	size_t offset, rest, tailLength;
+	unsigned long high = (unsigned long) (length >> 29), low = (unsigned long) (length << 3);
+	int i;
+
+	for (offset = 0  ;  length - offset >= 64  ;  offset += 64)
+		block (state, message + offset);
+	rest = length - offset;
+	memset (tail, 0, sizeof (tail));
+	memcpy (tail, message + offset, rest);
+	tail [rest] = 0x80;
+	tailLength = (rest < 56) ? 64 : 128;
+	for (i = 0  ;  i < 4  ;  ++i)
+	{
+		tail [tailLength - 5 - i] = (unsigned char) ((high >> (8 * i)) & 0xff);
+		tail [tailLength - 1 - i] = (unsigned char) ((low >> (8 * i)) & 0xff);
+	}
+	for (offset = 0  ;  offset < tailLength  ;  offset += 64)
+		block (state, tail + offset);
+	for (i = 0  ;  i < 4 * stateLength  ;  ++i)
+		digest [i] = (unsigned char) ((state [i / 4] >> (24 - 8 * (i % 4))) & 0xff);
+}
+
+/*  Checks the checksum which ends the index. Git does not compute it when
+ *  "index.skipHash" is set, leaving it zero.
+ */
+static boolean isChecksumValid (const gitIndex *const index)
+{
+	const unsigned char *const checksum = index->buffer + index->length;
+	unsigned char digest [32];
+	boolean skipped = TRUE;
+	size_t i;
+
+	for (i = 0  ;  i < index->hashLength  &&  skipped  ;  ++i)
+		skipped = (boolean) (checksum [i] == 0);
+	if (skipped)
+		return TRUE;
+	else if (index->hashLength == 32)
+	{
+		unsigned long state [8] = {
+			0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+			0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL
+		};
+		hashMessage (index->buffer, index->length, state, 8, sha256Block, digest);
+	}
+	else
+	{
+		unsigned long state [5] = {
+			0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL,
+			0xc3d2e1f0UL
+		};
+		hashMessage (index->buffer, index->length, state, 5, sha1Block, digest);
+	}
+	return (boolean) (memcmp (digest, checksum, index->hashLength) == 0);
+}
+
+/*  Reads the variable length integer of version 4 indexes, the same encoding
+ *  as the offsets of pack files.
+ */
+static boolean readVarInt (
+		const unsigned char **const pp, const unsigned char *const end,
+		size_t *const pValue)
+{
+	const unsigned char *p = *pp;
+	size_t value;
+
+	if (p >= end)
+		return FALSE;
+	value = *p & 0x7f;
+	while (*p++ & 0x80)
+	{
+		if (p >= end)
+			return FALSE;
+		value = ((value + 1) << 7) | (*p & 0x7f);
+	}
+	*pp = p;
+	*pValue = value;
+	return TRUE;
+}
+
+static char *readWholeFile (const char *const fileName, size_t *const pLength)
+{
+	FILE *const fp = fopen (fileName, "rb");
+	char *result = NULL;
+
+	if (fp != NULL)
+	{
+		size_t max = 65536, length = 0, count;
+
+		result = xMalloc (max, char);
+		while ((count = fread (result + length, (size_t) 1,
+				max - length, fp)) > 0)
+		{
+			length += count;
+			if (length == max)
+			{
+				max *= 2;
+				result = xRealloc (result, max, char);
+			}
+		}
+		if (ferror (fp))
+		{
+			eFree (result);
+			result = NULL;
+		}
+		*pLength = length;
+		fclose (fp);
+	}
+	return result;
+}
+
+/*  Repositories using SHA-256 object names say so in their configuration;
+ *  the index itself does not record the length of object names.
+ */
+static boolean usesSha256 (const char *const gitDir)
+{
+	vString *const configName = combinePathAndFile (gitDir, "config");
+	FILE *const fp = fopen (vStringValue (configName), "r");
+	boolean result = FALSE;
+
+	if (fp != NULL)
+	{
+		vString *const line = vStringNew ();
+		while (! result  &&  readLine (line, fp) != NULL)
+		{
+			vStringCopyToLower (line, line);
+			result = (boolean) (strstr (vStringValue (line), "objectformat") != NULL  &&
+					strstr (vStringValue (line), "sha256") != NULL);
+		}
+		vStringDelete (line);
+		fclose (fp);
+	}
+	vStringDelete (configName);
+	return result;
+}
+
+/*  Walks the entries of the index, calling `callback' for those present in
+ *  the working tree unless it is NULL, and pointing `pExtensions' (if not
+ *  NULL) at the extensions which follow them. Returns FALSE if the index is
+ *  not well formed, in which case nothing is reported when first checked.
+ */
+static boolean walkIndexEntries (
+		const gitIndex *const index, const gitEntryCallback callback,
+		void *const data, const unsigned char **const pExtensions)
+{
+	const unsigned char *p = index->buffer + INDEX_HEADER_SIZE;
+	const unsigned char *const end = index->buffer + index->length;
+	vString *const name = vStringNew ();
+	vString *const previous = vStringNew ();
+	boolean ok = TRUE;
+	unsigned long i;
+
+	for (i = 0  ;  ok  &&  i < index->count  ;  ++i)
+	{
+		const unsigned char *const entry = p;
+		const unsigned char *nameEnd;
+		unsigned long mode, size, flags, xflags = 0;
+
+		if ((size_t) (end - p) < ENTRY_STAT_SIZE + index->hashLength + 2)
+		{
+			ok = FALSE;
+			break;
+		}
+		mode = readBigEndian (p + 24, 4);
+		size = readBigEndian (p + 36, 4);
+		p += ENTRY_STAT_SIZE + index->hashLength;
+		flags = readBigEndian (p, 2);
+		p += 2;
+		if (index->version >= 3  &&  (flags & FLAG_EXTENDED) != 0)
+		{
+			if (end - p < 2)
+			{
+				ok = FALSE;
+				break;
+			}
+			xflags = readBigEndian (p, 2);
+			p += 2;
+		}
+
+		vStringClear (name);
+		if (index->version >= 4)
+		{
+			size_t strip;
+			if (! readVarInt (&p, end, &strip)  ||
+					strip > vStringLength (previous))
+			{
+				ok = FALSE;
+				break;
+			}
+			vStringNCopyS (name, vStringValue (previous),
+					vStringLength (previous) - strip);
+		}
+		nameEnd = memchr (p, '\0', (size_t) (end - p));
+		if (nameEnd == NULL)
+		{
+			ok = FALSE;
+			break;
+		}
+		vStringNCatS (name, (const char *) p, (size_t) (nameEnd - p));
+		if (index->version >= 4)
+			p = nameEnd + 1;
+		else
+		{
+			/*  Entries are padded with 1 to 8 NUL bytes to a multiple of 8.
+			 */
+			const size_t entryLength =
+					((size_t) (nameEnd - entry) + 8) & ~(size_t) 7;
+			if ((flags & FLAG_NAME_LENGTH) != FLAG_NAME_LENGTH  &&
+				(size_t) (nameEnd - p) != (flags & FLAG_NAME_LENGTH))
+			{
+				ok = FALSE;
+				break;
+			}
+			if ((size_t) (end - entry) < entryLength)
+			{
+				ok = FALSE;
+				break;
+			}
+			p = entry + entryLength;
+		}
+
+		/*  Unmerged files have an entry for each stage; sparse checkouts
+		 *  leave out the files (and directories) they skip.
+		 */
+		if (callback != NULL  &&
+			(xflags & XFLAG_SKIP_WORKTREE) == 0  &&
+			strcmp (vStringValue (name), vStringValue (previous)) != 0)
+		{
+			switch (mode & MODE_TYPE_MASK)
+			{
+				case MODE_FILE:
+					callback (vStringValue (name), GIT_ENTRY_FILE, size, data);
+					break;
+				case MODE_LINK:
+					callback (vStringValue (name), GIT_ENTRY_LINK, size, data);
+					break;
+				case MODE_GITLINK:
+					callback (vStringValue (name), GIT_ENTRY_SUBMODULE, size, data);
+					break;
+				default:
+					break;
+			}
+		}
+		vStringCopy (previous, name);
+	}
+	if (pExtensions != NULL)
+		*pExtensions = p;
+	vStringDelete (name);
+	vStringDelete (previous);
+	return ok;
+}
+
+/*  Checks the extensions following the entries of the index. Those whose
+ *  signature starts with an upper case letter only cache information and
+ *  may be ignored; any other, such as the "link" to the shared index of a
+ *  split index or the "sdir" of a sparse index, changes the meaning of the
+ *  entries. Returns FALSE, naming it in `signature', if there is one.
+ */
+static boolean hasOnlyOptionalExtensions (
+		const gitIndex *const index, const unsigned char *p,
+		char *const signature)
+{
+	const unsigned char *const end = index->buffer + index->length;
+	boolean result = TRUE;
+
+	while (result  &&  (size_t) (end - p) >= EXTENSION_HEADER_SIZE)
+	{
+		const unsigned long size = readBigEndian (p + 4, 4);
+
+		if (p [0] < 'A'  ||  p [0] > 'Z'  ||
+			size > (size_t) (end - p) - EXTENSION_HEADER_SIZE)
+		{
+			memcpy (signature, p, (size_t) 4);
+			signature [4] = '\0';
+			result = FALSE;
+		}
+		else
+			p += EXTENSION_HEADER_SIZE + size;
+	}
+	return result;
+}
+
+/*  Reports the files tracked in the git working tree whose top directory is
+ *  `dirName', in the order of the index (that is, sorted by name). Returns
+ *  FALSE, having reported nothing, if `dirName' has no index which can be
+ *  read.
+ */
+extern boolean readGitIndex (
+		const char *const dirName, const gitEntryCallback callback,
+		void *const data)
+{
+	vString *const gitDir = combinePathAndFile (dirName, ".git");
+	vString *const indexName = combinePathAndFile (vStringValue (gitDir), "index");
+	boolean result = FALSE;
+	size_t length = 0;
+	char *const buffer = readWholeFile (vStringValue (indexName), &length);
+
+	if (buffer != NULL)
+	{
+		const unsigned char *extensions = NULL;
+		boolean usable = TRUE;
+		char signature [5];
+		gitIndex index;
+
+		index.buffer = (const unsigned char *) buffer;
+		index.hashLength = usesSha256 (vStringValue (gitDir)) ? 32 : 20;
+		if (length >= INDEX_HEADER_SIZE + index.hashLength  &&
+			memcmp (buffer, INDEX_SIGNATURE, 4) == 0)
+		{
+			index.length = length - index.hashLength;
+			index.version = readBigEndian (index.buffer + 4, 4);
+			index.count = readBigEndian (index.buffer + 8, 4);
+			if (index.version >= 2  &&  index.version <= 4  &&
+				isChecksumValid (&index)  &&
+				walkIndexEntries (&index, NULL, NULL, &extensions))
+			{
+				usable = hasOnlyOptionalExtensions (&index, extensions, signature);
+				if (usable)
+				{
+					verbose ("READING files of \"%s\" from its git index\n", dirName);
+					walkIndexEntries (&index, callback, data, NULL);
+					result = TRUE;
+				}
+				else
+					verbose ("ignoring git index \"%s\" (\"%s\" extension)\n",
+							vStringValue (indexName), signature);
+			}
+		}
+		if (! result  &&  usable)
+			error (WARNING, "cannot read git index \"%s\"",
+					vStringValue (indexName));
+		eFree (buffer);
+	}
+	vStringDelete (indexName);
+	vStringDelete (gitDir);
+	return result;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
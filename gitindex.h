@@ -0,0 +1,39 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to gitindex.c
+*/
+#ifndef _GITINDEX_H
+#define _GITINDEX_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum eGitEntryType {
+	GIT_ENTRY_FILE,       /* regular file */
+	GIT_ENTRY_LINK,       /* symbolic link */
+	GIT_ENTRY_SUBMODULE   /* working tree of a submodule */
+} gitEntryType;
+
+/*  Called for each file of the index, with its name relative to the top of
+ *  the working tree and its size as last recorded in the index.
+ */
+typedef void (*gitEntryCallback) (const char *const name,
+		const gitEntryType type, const unsigned long size, void *const data);
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean readGitIndex (const char *const dirName, const gitEntryCallback callback, void *const data);
+
+#endif  /* _GITINDEX_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,337 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to honor the ".gitignore" and ".ignore"
+*   files found while recursing into directories, for the --ignore-files
+*   option. The rules of each directory are read once, when it is entered,
+*   and apply to the files below it, the rules of deeper directories taking
+*   precedence over those of the directories containing them, as with git.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+
+#include "debug.h"
+#include "ignorefile.h"
+#include "options.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sIgnoreRule {
+	char *pattern;
+	boolean negated;        /* "!pattern": the file is not ignored */
+	boolean directoryOnly;  /* "pattern/": only matches directories */
+	boolean anchored;       /* matched against the path below the directory */
+	boolean literal;        /* pattern holds no wildcard */
+} ignoreRule;
+
+/*  The rules of the ignore files of one directory.
+ */
+typedef struct sIgnoreRules {
+	ignoreRule *rules;
+	unsigned int count, max;
+	size_t prefixLength;    /* length of the names of the directory's files
+	                           before the part the rules apply to */
+} ignoreRules;
+
+/*
+*   DATA DEFINITIONS
+*/
+
+/*  The ignore files to whose rules the directory being read is subject, one
+ *  rule set for each directory recursed into.
+ */
+static struct {
+	ignoreRules *sets;
+	unsigned int count, max;
+	unsigned int rules;  /* number of rules of all sets */
+} Stack = { NULL, 0, 0, 0 };
+
+static const char *const IgnoreFileNames [] = { ".gitignore", ".ignore", NULL };
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Matches the bracket expression starting at `p', returning the character
+ *  following it, or NULL if `c' does not match. An unterminated expression
+ *  matches a literal '['.
+ */
+static const char *matchBracket (const char *p, const int c)
+{
+	const char *const start = p;
+	boolean negated = FALSE, matched = FALSE;
+
+	++p;
+	if (*p == '!'  ||  *p == '^')
+	{
+		negated = TRUE;
+		++p;
+	}
+	do
+	{
+		int low, high;
+
+		if (*p == '\0')
+			return (c == '[') ? start + 1 : NULL;
+		if (*p == '\\'  &&  p [1] != '\0')
+			++p;
+		low = high = (unsigned char) *p++;
+		if (*p == '-'  &&  p [1] != ']'  &&  p [1] != '\0')
+		{
+			++p;
+			if (*p == '\\'  &&  p [1] != '\0')
+				++p;
+			high = (unsigned char) *p++;
+		}
+		if (low <= c  &&  c <= high)
+			matched = TRUE;
+	} while (*p != ']');
+
+	return (matched != negated) ? p + 1 : NULL;
+}
+
+/*  Matches `name' against the pattern `p' of an ignore file, in which '*' and
+ *  '?' do not match '/', while "**" matches across directories.
+ */
+static boolean matchPattern (const char *p, const char *name)
+{
+	while (*p != '\0')
+	{
+		if (p [0] == '*'  &&  p [1] == '*'  &&  p [2] == '\0')
+			return TRUE;
+		else if (p [0] == '*'  &&  p [1] == '*'  &&  p [2] == '/')
+		{
+			/*  "**\/" matches any number of directories, even none.
+			 */
+			p += 3;
+			for (;;)
+			{
+				const char *const separator = strchr (name, '/');
+				if (matchPattern (p, name))
+					return TRUE;
+				if (separator == NULL)
+					return FALSE;
+				name = separator + 1;
+			}
+		}
+		else if (*p == '*')
+		{
+			++p;
+			for (;;)
+			{
+				if (matchPattern (p, name))
+					return TRUE;
+				if (*name == '\0'  ||  *name == '/')
+					return FALSE;
+				++name;
+			}
+		}
+		else if (*name == '\0')
+			return FALSE;
+		else if (*p == '?')
+		{
+			if (*name == '/')
+				return FALSE;
+			++p;
+			++name;
+		}
+		else if (*p == '[')
+		{
+			if (*name == '/')
+				return FALSE;
+			p = matchBracket (p, (unsigned char) *name);
+			if (p == NULL)
+				return FALSE;
+			++name;
+		}
+		else
+		{
+			if (*p == '\\'  &&  p [1] != '\0')
+				++p;
+			if (*p != *name)
+				return FALSE;
+			++p;
+			++name;
+		}
+	}
+	return (boolean) (*name == '\0');
+}
+
+static boolean isRuleMatched (
+		const ignoreRule *const rule, const char *const path,
+		const boolean isDirectory)
+{
+	boolean result = FALSE;
+
+	if (isDirectory  ||  ! rule->directoryOnly)
+	{
+		const char *const base = strrchr (path, '/');
+		const char *const name = rule->anchored ? path :
+				(base == NULL) ? path : base + 1;
+
+		if (rule->literal)
+			result = (boolean) (strcmp (rule->pattern, name) == 0);
+		else
+			result = matchPattern (rule->pattern, name);
+	}
+	return result;
+}
+
+/*  Adds the rule of a line of an ignore file, following gitignore(5).
+ */
+static void addRule (ignoreRules *const set, vString *const line)
+{
+	char *p = vStringValue (line);
+	size_t length;
+	ignoreRule rule;
+
+	memset (&rule, 0, sizeof (rule));
+	vStringStripNewline (line);
+	length = vStringLength (line);
+	if (length > 0  &&  p [length - 1] == '\r')
+		--length;
+
+	/*  Trailing spaces are ignored unless escaped.
+	 */
+	while (length > 0  &&  p [length - 1] == ' '  &&
+			! (length > 1  &&  p [length - 2] == '\\'))
+		--length;
+	p [length] = '\0';
+
+	if (length == 0  ||  p [0] == '#')
+		return;
+	if (p [0] == '!')
+	{
+		rule.negated = TRUE;
+		++p;
+		--length;
+	}
+	else if (p [0] == '\\'  &&  (p [1] == '#'  ||  p [1] == '!'))
+	{
+		++p;
+		--length;
+	}
+	if (length > 0  &&  p [length - 1] == '/')
+	{
+		rule.directoryOnly = TRUE;
+		p [--length] = '\0';
+	}
+	if (length == 0)
+		return;
+	rule.anchored = (boolean) (strchr (p, '/') != NULL);
+	if (p [0] == '/')
+		++p;
+	rule.literal = (boolean) (strpbrk (p, "*?[\\") == NULL);
+	rule.pattern = eStrdup (p);
+
+	if (set->count == set->max)
+	{
+		set->max = (set->max == 0) ? 16 : 2 * set->max;
+		set->rules = xRealloc (set->rules, set->max, ignoreRule);
+	}
+	set->rules [set->count++] = rule;
+}
+
+/*  Reads the ignore files of the directory `dirName', whose files are named
+ *  with a prefix of `prefixLength' characters (the directory name and a
+ *  separator, if any), and subjects the files below it to their rules until
+ *  popIgnoreFiles () is called.
+ */
+extern void pushIgnoreFiles (const char *const dirName, const size_t prefixLength)
+{
+	ignoreRules *set;
+	unsigned int i;
+
+	if (Stack.count == Stack.max)
+	{
+		Stack.max = (Stack.max == 0) ? 32 : 2 * Stack.max;
+		Stack.sets = xRealloc (Stack.sets, Stack.max, ignoreRules);
+	}
+	set = &Stack.sets [Stack.count++];
+	set->rules = NULL;
+	set->count = set->max = 0;
+	set->prefixLength = prefixLength;
+
+	for (i = 0  ;  IgnoreFileNames [i] != NULL  ;  ++i)
+	{
+		vString *const fileName = combinePathAndFile (dirName, IgnoreFileNames [i]);
+		FILE *const fp = fopen (vStringValue (fileName), "r");
+
+		if (fp != NULL)
+		{
+			vString *const line = vStringNew ();
+
+			verbose ("reading ignore file \"%s\"\n", vStringValue (fileName));
+			while (readLine (line, fp) != NULL)
+				addRule (set, line);
+			vStringDelete (line);
+			fclose (fp);
+		}
+		vStringDelete (fileName);
+	}
+	Stack.rules += set->count;
+}
+
+extern void popIgnoreFiles (void)
+{
+	ignoreRules *set;
+	unsigned int i;
+
+	Assert (Stack.count > 0);
+	set = &Stack.sets [--Stack.count];
+	for (i = 0  ;  i < set->count  ;  ++i)
+		eFree (set->rules [i].pattern);
+	if (set->rules != NULL)
+		eFree (set->rules);
+	Stack.rules -= set->count;
+
+	if (Stack.count == 0)
+	{
+		eFree (Stack.sets);
+		Stack.sets = NULL;
+		Stack.max = 0;
+	}
+}
+
+/*  Determines whether the ignore files in effect ignore the file or
+ *  directory `fileName', found in the directory last pushed. The last rule
+ *  of the deepest ignore file matching it decides.
+ */
+extern boolean isIgnoredByFiles (const char *const fileName, const boolean isDirectory)
+{
+	boolean result = FALSE;
+	boolean decided = FALSE;
+	unsigned int i, j;
+
+	for (i = Stack.count  ;  Stack.rules > 0  &&  ! decided  &&  i > 0  ;  --i)
+	{
+		const ignoreRules *const set = &Stack.sets [i - 1];
+		const char *const path = fileName + set->prefixLength;
+
+		Assert (strlen (fileName) >= set->prefixLength);
+		for (j = set->count  ;  ! decided  &&  j > 0  ;  --j)
+		{
+			const ignoreRule *const rule = &set->rules [j - 1];
+			if (isRuleMatched (rule, path, isDirectory))
+			{
+				result = (boolean) (! rule->negated);
+				decided = TRUE;
+			}
+		}
+	}
+	return result;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
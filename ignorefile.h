@@ -0,0 +1,26 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to ignorefile.c
+*/
+#ifndef _IGNOREFILE_H
+#define _IGNOREFILE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void pushIgnoreFiles (const char *const dirName, const size_t prefixLength);
+extern void popIgnoreFiles (void);
+extern boolean isIgnoredByFiles (const char *const fileName, const boolean isDirectory);
+
+#endif  /* _IGNOREFILE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
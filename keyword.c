@@ -14,6 +14,7 @@
 */
 #include "general.h"  /* must always come first */
 
+#include <ctype.h>
 #include <string.h>
 
 #include "debug.h"
@@ -24,7 +25,7 @@
 /*
 *   MACROS
 */
-#define HASH_EXPONENT 7  /* must be less than 17 */
+#define MIN_TABLE_SIZE 16  /* initial buckets per language; a power of 2 */
 
 /*
 *   DATA DECLARATIONS
@@ -32,85 +33,117 @@
 typedef struct sHashEntry {
 	struct sHashEntry *next;
 	const char *string;
-	langType language;
+	unsigned long hash;
 	int value;
 } hashEntry;
 
+/*  Each language has its own table, so that looking up a keyword never has to
+ *  skip over the keywords of other languages. A table is doubled in size
+ *  whenever it becomes half full, keeping its chains short.
+ */
+typedef struct sKeywordTable {
+	hashEntry **buckets;
+	unsigned int size;   /* number of buckets (zero or a power of 2) */
+	unsigned int count;  /* number of keywords */
+} keywordTable;
+
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 1 << HASH_EXPONENT;
-static hashEntry **HashTable = NULL;
+static keywordTable *Tables = NULL;  /* indexed by language */
+static int TableUpper = -1;          /* upper language index in Tables */
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+static keywordTable *getKeywordTable (const langType language)
 {
-	static boolean allocated = FALSE;
-
-	if (! allocated)
+	Assert (language >= 0);
+	if (language > TableUpper)
 	{
-		unsigned int i;
-
-		HashTable = xMalloc (TableSize, hashEntry*);
-
-		for (i = 0  ;  i < TableSize  ;  ++i)
-			HashTable [i] = NULL;
-
-		allocated = TRUE;
+		int i;
+		Tables = xRealloc (Tables, language + 1, keywordTable);
+		for (i = TableUpper + 1  ;  i <= language  ;  ++i)
+		{
+			Tables [i].buckets = NULL;
+			Tables [i].size    = 0;
+			Tables [i].count   = 0;
+		}
+		TableUpper = language;
 	}
-	return HashTable;
+	return Tables + language;
 }
 
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
+/*  FNV-1a hash of `string', or of its lower case version if `fold' is set;
+ *  the low bits select the bucket.
+ */
+static unsigned long hashValue (const char *const string, const boolean fold)
 {
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry;
+	unsigned long value = 2166136261UL;
+	const unsigned char *p;
 
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
+	Assert (string != NULL);
 
-	return entry;
+	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+	{
+		value ^= fold ? (unsigned char) tolower ((int) *p) : *p;
+		value = (value * 16777619UL) & 0xffffffffUL;
+	}
+	return value;
 }
 
-static unsigned long hashValue (const char *const string)
+/*  Compares `string', converted to lower case, with `keyword'. */
+static boolean isFoldedKeyword (const char *string, const char *keyword)
 {
-	unsigned long value = 0;
-	const unsigned char *p;
+	while (*string != '\0'  &&
+			tolower ((int) (unsigned char) *string) == (unsigned char) *keyword)
+	{
+		++string;
+		++keyword;
+	}
+	return (boolean) (*string == '\0'  &&  *keyword == '\0');
+}
 
-	Assert (string != NULL);
+static void growKeywordTable (keywordTable *const table)
+{
+	const unsigned int size =
+			(table->size == 0) ? MIN_TABLE_SIZE : 2 * table->size;
+	hashEntry **const buckets = xCalloc (size, hashEntry*);
+	unsigned int i;
 
-	/*  We combine the various words of the multiword key using the method
-	 *  described on page 512 of Vol. 3 of "The Art of Computer Programming".
-	 */
-	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+	for (i = 0  ;  i < table->size  ;  ++i)
 	{
-		value <<= 1;
-		if (value & 0x00000100L)
-			value = (value & 0x000000ffL) + 1L;
-		value ^= *p;
-	}
-	/*  Algorithm from page 509 of Vol. 3 of "The Art of Computer Programming"
-	 *  Treats "value" as a 16-bit integer plus 16-bit fraction.
-	 */
-	value *= 40503L;               /* = 2^16 * 0.6180339887 ("golden ratio") */
-	value &= 0x0000ffffL;          /* keep fractional part */
-	value >>= 16 - HASH_EXPONENT;  /* scale up by hash size and move down */
+		hashEntry *entry = table->buckets [i];
 
-	return value;
+		while (entry != NULL)
+		{
+			hashEntry *const next = entry->next;
+			hashEntry **tail = &buckets [entry->hash & (size - 1)];
+
+			/* keep the entries of each chain in order of addition */
+			while (*tail != NULL)
+				tail = &(*tail)->next;
+			entry->next = NULL;
+			*tail = entry;
+			entry = next;
+		}
+	}
+	if (table->buckets != NULL)
+		eFree (table->buckets);
+	table->buckets = buckets;
+	table->size = size;
 }
 
 static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+		const char *const string, unsigned long hash, int value)
 {
 	hashEntry *const entry = xMalloc (1, hashEntry);
 
-	entry->next     = NULL;
-	entry->string   = string;
-	entry->language = language;
-	entry->value    = value;
+	entry->next   = NULL;
+	entry->string = string;
+	entry->hash   = hash;
+	entry->value  = value;
 
 	return entry;
 }
@@ -122,63 +155,70 @@ static hashEntry *newEntry (
  */
 extern void addKeyword (const char *const string, langType language, int value)
 {
-	const unsigned long hashedValue = hashValue (string);
-	hashEntry *entry = getHashTableEntry (hashedValue);
+	keywordTable *const table = getKeywordTable (language);
+	const unsigned long hash = hashValue (string, FALSE);
+	hashEntry **tail;
 
-	if (entry == NULL)
+	if (2 * table->count >= table->size)
+		growKeywordTable (table);
+
+	tail = &table->buckets [hash & (table->size - 1)];
+	while (*tail != NULL)
 	{
-		hashEntry **const table = getHashTable ();
-		table [hashedValue] = newEntry (string, language, value);
+		if ((*tail)->hash == hash  &&  strcmp (string, (*tail)->string) == 0)
+		{
+			Assert (("Already in table" == NULL));
+		}
+		tail = &(*tail)->next;
 	}
-	else
+	*tail = newEntry (string, hash, value);
+	++table->count;
+}
+
+static int findKeyword (
+		const char *const string, langType language, const boolean fold)
+{
+	int result = -1;
+
+	if (language >= 0  &&  language <= TableUpper  &&
+		Tables [language].count > 0)
 	{
-		hashEntry *prev = NULL;
+		const keywordTable *const table = Tables + language;
+		const unsigned long hash = hashValue (string, fold);
+		const hashEntry *entry = table->buckets [hash & (table->size - 1)];
 
 		while (entry != NULL)
 		{
-			if (language == entry->language  &&
-				strcmp (string, entry->string) == 0)
+			if (entry->hash == hash  &&  (fold ?
+					isFoldedKeyword (string, entry->string) :
+					strcmp (string, entry->string) == 0))
 			{
-				Assert (("Already in table" == NULL));
+				result = entry->value;
+				break;
 			}
-			prev = entry;
 			entry = entry->next;
 		}
-		if (entry == NULL)
-		{
-			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
-		}
 	}
+	return result;
 }
 
 extern int lookupKeyword (const char *const string, langType language)
 {
-	const unsigned long hashedValue = hashValue (string);
-	hashEntry *entry = getHashTableEntry (hashedValue);
-	int result = -1;
-
-	while (entry != NULL)
-	{
-		if (language == entry->language  &&  strcmp (string, entry->string) == 0)
-		{
-			result = entry->value;
-			break;
-		}
-		entry = entry->next;
-	}
-	return result;
+	return findKeyword (string, language, FALSE);
 }
 
 extern void freeKeywordTable (void)
 {
-	if (HashTable != NULL)
+	int language;
+
+	for (language = 0  ;  language <= TableUpper  ;  ++language)
 	{
+		keywordTable *const table = Tables + language;
 		unsigned int i;
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
+		for (i = 0  ;  i < table->size  ;  ++i)
 		{
-			hashEntry *entry = HashTable [i];
+			hashEntry *entry = table->buckets [i];
 
 			while (entry != NULL)
 			{
@@ -187,31 +227,27 @@ extern void freeKeywordTable (void)
 				entry = next;
 			}
 		}
-		eFree (HashTable);
+		if (table->buckets != NULL)
+			eFree (table->buckets);
 	}
+	if (Tables != NULL)
+		eFree (Tables);
+	Tables = NULL;
+	TableUpper = -1;
 }
 
+/*  Looks up `name' ignoring its case, without making a lower case copy. */
 extern int analyzeToken (vString *const name, langType language)
 {
-	vString *keyword = vStringNew ();
-	int result;
-	vStringCopyToLower (keyword, name);
-	result = lookupKeyword (vStringValue (keyword), language);
-	vStringDelete (keyword);
-	return result;
+	return findKeyword (vStringValue (name), language, TRUE);
 }
 
 #ifdef DEBUG
 
-static void printEntry (const hashEntry *const entry)
+static unsigned int printBucket (const keywordTable *const table,
+								 const unsigned int i)
 {
-	printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
-}
-
-static unsigned int printBucket (const unsigned int i)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry = table [i];
+	const hashEntry *entry = table->buckets [i];
 	unsigned int measure = 1;
 	boolean first = TRUE;
 
@@ -227,7 +263,7 @@ static unsigned int printBucket (const unsigned int i)
 			printf (" ");
 			first = FALSE;
 		}
-		printEntry (entry);
+		printf ("  %-15s\n", entry->string);
 		entry = entry->next;
 		measure = 2 * measure;
 	}
@@ -236,21 +272,30 @@ static unsigned int printBucket (const unsigned int i)
 
 extern void printKeywordTable (void)
 {
-	unsigned long emptyBucketCount = 0;
-	unsigned long measure = 0;
-	unsigned int i;
+	int language;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (language = 0  ;  language <= TableUpper  ;  ++language)
 	{
-		const unsigned int pass = printBucket (i);
+		const keywordTable *const table = Tables + language;
+		unsigned long emptyBucketCount = 0;
+		unsigned long measure = 0;
+		unsigned int i;
 
-		measure += pass;
-		if (pass == 0)
-			++emptyBucketCount;
-	}
+		if (table->count == 0)
+			continue;
+		printf ("%s: %u keywords in %u buckets\n",
+				getLanguageName (language), table->count, table->size);
+		for (i = 0  ;  i < table->size  ;  ++i)
+		{
+			const unsigned int pass = printBucket (table, i);
 
-	printf ("spread measure = %ld\n", measure);
-	printf ("%ld empty buckets\n", emptyBucketCount);
+			measure += pass;
+			if (pass == 0)
+				++emptyBucketCount;
+		}
+		printf ("spread measure = %ld\n", measure);
+		printf ("%ld empty buckets\n", emptyBucketCount);
+	}
 }
 
 #endif
@@ -22,6 +22,7 @@
 
 #ifdef HAVE_REGCOMP
 # include <ctype.h>
+# include <limits.h>
 # include <stddef.h>
 # ifdef HAVE_SYS_TYPES_H
 #  include <sys/types.h>  /* declare off_t (not known to regex.h on FreeBSD) */
@@ -66,6 +67,9 @@ enum pType { PTRN_TAG, PTRN_CALLBACK };
 
 typedef struct {
 	regex_t *pattern;
+	char *literal;  /* string contained in every matching line, or NULL */
+	size_t literalLength;
+	boolean literalFolded;  /* literal is lower case, to match in any case */
 	enum pType type;
 	union {
 		struct {
@@ -83,6 +87,17 @@ typedef struct {
 typedef struct {
 	regexPattern *patterns;
 	unsigned int count;
+
+	/* Prefilter, built on first use after the set changes: indices of the
+	 * patterns having a literal, grouped by the first character of the
+	 * literal (those starting with character `c' are listed in `byFirst'
+	 * from `firstIndex [c]' up to `firstIndex [c + 1]').
+	 */
+	unsigned int *firstIndex;
+	unsigned int *byFirst;
+	unsigned int filtered;  /* number of patterns having a literal */
+	int onlyFirst;          /* first character of all literals, or -1 */
+	boolean *candidate;     /* patterns which may match the current line */
 } patternSet;
 
 /*
@@ -99,6 +114,25 @@ static int SetUpper = -1;  /* upper language index in list */
 *   FUNCTION DEFINITIONS
 */
 
+static void discardPrefilter (patternSet* const set)
+{
+	if (set->firstIndex != NULL)
+	{
+		eFree (set->firstIndex);
+		set->firstIndex = NULL;
+	}
+	if (set->byFirst != NULL)
+	{
+		eFree (set->byFirst);
+		set->byFirst = NULL;
+	}
+	if (set->candidate != NULL)
+	{
+		eFree (set->candidate);
+		set->candidate = NULL;
+	}
+}
+
 static void clearPatternSet (const langType language)
 {
 	if (language <= SetUpper)
@@ -113,6 +147,11 @@ static void clearPatternSet (const langType language)
 #endif
 			eFree (p->pattern);
 			p->pattern = NULL;
+			if (p->literal != NULL)
+			{
+				eFree (p->literal);
+				p->literal = NULL;
+			}
 
 			if (p->type == PTRN_TAG)
 			{
@@ -131,6 +170,7 @@ static void clearPatternSet (const langType language)
 			eFree (set->patterns);
 		set->patterns = NULL;
 		set->count = 0;
+		discardPrefilter (set);
 	}
 }
 
@@ -251,7 +291,7 @@ static boolean parseTagRegex (
 
 static void addCompiledTagPattern (
 		const langType language, regex_t* const pattern,
-		char* const name, const char kind, char* const kindName,
+		char* const literal, const boolean folded, char* const name, const char kind, char* const kindName,
 		char *const description)
 {
 	patternSet* set;
@@ -264,6 +304,9 @@ static void addCompiledTagPattern (
 		{
 			Sets [i].patterns = NULL;
 			Sets [i].count = 0;
+			Sets [i].firstIndex = NULL;
+			Sets [i].byFirst = NULL;
+			Sets [i].candidate = NULL;
 		}
 		SetUpper = language;
 	}
@@ -271,8 +314,12 @@ static void addCompiledTagPattern (
 	set->patterns = xRealloc (set->patterns, (set->count + 1), regexPattern);
 	ptrn = &set->patterns [set->count];
 	set->count += 1;
+	discardPrefilter (set);
 
 	ptrn->pattern = pattern;
+	ptrn->literal = literal;
+	ptrn->literalLength = (literal == NULL) ? 0 : strlen (literal);
+	ptrn->literalFolded = folded;
 	ptrn->type    = PTRN_TAG;
 	ptrn->u.tag.name_pattern = name;
 	ptrn->u.tag.kind.enabled = TRUE;
@@ -283,6 +330,7 @@ static void addCompiledTagPattern (
 
 static void addCompiledCallbackPattern (
 		const langType language, regex_t* const pattern,
+		char* const literal, const boolean folded,
 		const regexCallback callback)
 {
 	patternSet* set;
@@ -295,6 +343,9 @@ static void addCompiledCallbackPattern (
 		{
 			Sets [i].patterns = NULL;
 			Sets [i].count = 0;
+			Sets [i].firstIndex = NULL;
+			Sets [i].byFirst = NULL;
+			Sets [i].candidate = NULL;
 		}
 		SetUpper = language;
 	}
@@ -302,15 +353,232 @@ static void addCompiledCallbackPattern (
 	set->patterns = xRealloc (set->patterns, (set->count + 1), regexPattern);
 	ptrn = &set->patterns [set->count];
 	set->count += 1;
+	discardPrefilter (set);
 
 	ptrn->pattern = pattern;
+	ptrn->literal = literal;
+	ptrn->literalLength = (literal == NULL) ? 0 : strlen (literal);
+	ptrn->literalFolded = folded;
 	ptrn->type    = PTRN_CALLBACK;
 	ptrn->u.callback.function = callback;
 }
 
 #if defined (POSIX_REGEX)
 
-static regex_t* compileRegex (const char* const regexp, const char* const flags)
+/* Skips the bracket expression starting just after `p'. Returns a pointer to
+ * the character following it, or NULL if it is not terminated.
+ */
+static const char* skipBracketExpression (const char* p)
+{
+	if (*p == '^')
+		++p;
+	if (*p == ']')
+		++p;
+	while (p != NULL  &&  *p != ']')
+	{
+		if (*p == '\0')
+			p = NULL;
+		else if (*p == '['  &&  p [1] != '\0'  &&  strchr (":.=", p [1]) != NULL)
+		{
+			const char delimiter [3] = { p [1], ']', '\0' };
+			p = strstr (p + 2, delimiter);
+			if (p != NULL)
+				p += 2;
+		}
+		else
+			++p;
+	}
+	return (p == NULL) ? NULL : p + 1;
+}
+
+/* Classes of the elements of a regular expression, as far as finding the
+ * literal strings it requires is concerned.
+ */
+enum eRegexToken {
+	RTOKEN_CHARACTER,   /* ordinary character */
+	RTOKEN_BRACKET,     /* start of bracket expression */
+	RTOKEN_GROUP,       /* start of group */
+	RTOKEN_GROUP_END,   /* end of group */
+	RTOKEN_ALTERNATIVE, /* alternation operator */
+	RTOKEN_OPTIONAL,    /* *, ? and intervals: previous atom may be absent */
+	RTOKEN_REPEATED,    /* +: previous atom may be repeated */
+	RTOKEN_OTHER        /* anything else, e.g. anchors or back-references */
+};
+
+/* Classifies the element of a regular expression starting at `p', storing
+ * the character it stands for in `c' and returning a pointer to the element
+ * following it. In basic regular expressions, operators are escaped (as GNU
+ * regex supports \+, \? and \|) while parentheses and braces are ordinary.
+ */
+static const char* regexToken (const char* p, const boolean extended,
+							   enum eRegexToken* const token, char* const c)
+{
+	const boolean escaped = (boolean) (p [0] == '\\'  &&  p [1] != '\0');
+	const char* const operators = extended ? "()|*?{+" : "()|?{+";
+	*c = escaped ? p [1] : p [0];
+	if (escaped ? (! extended  &&  strchr (operators, *c) != NULL) :
+			(*c == '*'  ||  (extended  &&  strchr (operators, *c) != NULL)))
+	{
+		switch (*c)
+		{
+			case '(': *token = RTOKEN_GROUP;       break;
+			case ')': *token = RTOKEN_GROUP_END;   break;
+			case '|': *token = RTOKEN_ALTERNATIVE; break;
+			case '+': *token = RTOKEN_REPEATED;    break;
+			default:  *token = RTOKEN_OPTIONAL;    break;
+		}
+	}
+	else if (escaped)
+		*token = (strchr ("^.[]$()|*+?{}\\/", *c) != NULL) ?
+				RTOKEN_CHARACTER : RTOKEN_OTHER;
+	else if (*c == '[')
+		*token = RTOKEN_BRACKET;
+	else if (*c == '.'  ||  *c == '^'  ||  *c == '$'  ||  *c == '\\')
+		*token = RTOKEN_OTHER;
+	else
+		*token = RTOKEN_CHARACTER;
+	return p + (escaped ? 2 : 1);
+}
+
+/* Skips the group starting just after `p'. Returns a pointer to the element
+ * following it, or NULL if it is not terminated. If `alternatives' is not
+ * NULL, it is set to whether the group has several alternatives.
+ */
+static const char* skipGroup (const char* p, const boolean extended,
+							  boolean* const alternatives)
+{
+	if (alternatives != NULL)
+		*alternatives = FALSE;
+	while (p != NULL)
+	{
+		enum eRegexToken token;
+		char c;
+		if (*p == '\0')
+			p = NULL;
+		else
+		{
+			p = regexToken (p, extended, &token, &c);
+			if (token == RTOKEN_BRACKET)
+				p = skipBracketExpression (p);
+			else if (token == RTOKEN_GROUP)
+				p = skipGroup (p, extended, NULL);
+			else if (token == RTOKEN_ALTERNATIVE  &&  alternatives != NULL)
+				*alternatives = TRUE;
+			else if (token == RTOKEN_GROUP_END)
+				break;
+		}
+	}
+	return p;
+}
+
+/* Returns the longest string found in every line matched by the regular
+ * expression `regexp', or NULL if there is none. This only looks at
+ * sequences of ordinary characters, possibly spanning groups, outside of
+ * anything optional, repeated or having alternatives, which is enough to rule
+ * out most lines for most patterns without running the regular expression on
+ * them. For case-insensitive expressions the string is in lower case (ctags
+ * runs in the C locale, so that this is how the expression sees it too).
+ */
+static char* requiredLiteral (const char* const regexp, const int cflags)
+{
+	const boolean extended = (boolean) ((cflags & REG_EXTENDED) != 0);
+	char* const run = xMalloc (strlen (regexp) + 1, char);
+	size_t runLength = 0;
+	size_t bestLength = 0;
+	char* result = NULL;
+	boolean valid = TRUE;
+	int depth = 0;
+	const char* p = regexp;
+	while (valid  &&  *p != '\0')
+	{
+		enum eRegexToken token;
+		char c;
+		boolean endOfRun = TRUE;
+		p = regexToken (p, extended, &token, &c);
+		switch (token)
+		{
+			case RTOKEN_CHARACTER:
+				run [runLength++] = (cflags & REG_ICASE) ?
+						(char) tolower ((unsigned char) c) : c;
+				endOfRun = FALSE;
+				break;
+
+			case RTOKEN_BRACKET:
+				p = skipBracketExpression (p);
+				valid = (boolean) (p != NULL);
+				break;
+
+			case RTOKEN_GROUP:
+			{
+				boolean alternatives;
+				const char* const end = skipGroup (p, extended, &alternatives);
+				enum eRegexToken next = RTOKEN_OTHER;
+				char nc;
+				if (end == NULL)
+					valid = FALSE;
+				else if (*end != '\0')
+					regexToken (end, extended, &next, &nc);
+				if (valid  &&  (alternatives  ||  next == RTOKEN_OPTIONAL))
+					p = end;
+				else
+				{
+					/* the group is matched exactly once: look inside */
+					++depth;
+					endOfRun = FALSE;
+				}
+				break;
+			}
+
+			case RTOKEN_GROUP_END:
+				if (depth > 0)
+				{
+					--depth;
+					endOfRun = FALSE;
+				}
+				break;
+
+			case RTOKEN_ALTERNATIVE:
+				valid = FALSE;
+				break;
+
+			case RTOKEN_OPTIONAL:
+				if (c == '{')
+				{
+					while (*p != '\0'  &&  *p++ != '}')
+						;
+				}
+				/* the previous character may be absent */
+				if (runLength > 0)
+					--runLength;
+				break;
+
+			default:
+				break;
+		}
+		if (valid  &&  (endOfRun  ||  *p == '\0'))
+		{
+			if (runLength > bestLength)
+			{
+				result = (result == NULL) ? xMalloc (runLength + 1, char) :
+						xRealloc (result, runLength + 1, char);
+				memcpy (result, run, runLength);
+				result [runLength] = '\0';
+				bestLength = runLength;
+			}
+			runLength = 0;
+		}
+	}
+	eFree (run);
+	if (! valid  &&  result != NULL)
+	{
+		eFree (result);
+		result = NULL;
+	}
+	return result;
+}
+
+static regex_t* compileRegex (const char* const regexp, const char* const flags,
+							  char** const literal, boolean* const folded)
 {
 	int cflags = REG_EXTENDED | REG_NEWLINE;
 	regex_t *result = NULL;
@@ -336,7 +604,11 @@ static regex_t* compileRegex (const char* const regexp, const char* const flags)
 		regfree (result);
 		eFree (result);
 		result = NULL;
+		*literal = NULL;
 	}
+	else
+		*literal = requiredLiteral (regexp, cflags);
+	*folded = (boolean) ((cflags & REG_ICASE) != 0);
 	return result;
 }
 
@@ -506,6 +778,115 @@ static boolean matchRegexPattern (const vString* const line,
 	return result;
 }
 
+/* Stores in `firsts' the characters which a line may have where the literal
+ * of `p' starts, and returns how many there are.
+ */
+static int literalFirsts (const regexPattern* const p, unsigned char firsts [2])
+{
+	int count = 0;
+	if (p->literal != NULL)
+	{
+		firsts [count++] = (unsigned char) p->literal [0];
+		if (p->literalFolded  &&  toupper (firsts [0]) != firsts [0])
+			firsts [count++] = (unsigned char) toupper (firsts [0]);
+	}
+	return count;
+}
+
+static boolean isLiteralAt (const regexPattern* const p,
+							const unsigned char* const s)
+{
+	boolean result;
+	if (! p->literalFolded)
+		result = (boolean) (memcmp (s, p->literal, p->literalLength) == 0);
+	else
+	{
+		size_t i = 0;
+		while (i < p->literalLength  &&
+				tolower (s [i]) == (unsigned char) p->literal [i])
+			++i;
+		result = (boolean) (i == p->literalLength);
+	}
+	return result;
+}
+
+static void buildPrefilter (patternSet* const set)
+{
+	unsigned char firsts [2];
+	unsigned int i;
+	int c, n, used = 0;
+	set->firstIndex = xCalloc (UCHAR_MAX + 2, unsigned int);
+	set->byFirst = xMalloc (2 * set->count, unsigned int);
+	set->candidate = xMalloc (set->count, boolean);
+	set->filtered = 0;
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		const int count = literalFirsts (set->patterns + i, firsts);
+		for (n = 0  ;  n < count  ;  ++n)
+			++set->firstIndex [firsts [n] + 1];
+		if (count > 0)
+			++set->filtered;
+	}
+	for (c = 0  ;  c <= UCHAR_MAX  ;  ++c)
+		set->firstIndex [c + 1] += set->firstIndex [c];
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		const int count = literalFirsts (set->patterns + i, firsts);
+		for (n = 0  ;  n < count  ;  ++n)
+			set->byFirst [set->firstIndex [firsts [n]]++] = i;
+	}
+	/* each firstIndex [c] now holds the start of c + 1, so shift them back */
+	for (c = UCHAR_MAX + 1  ;  c > 0  ;  --c)
+		set->firstIndex [c] = set->firstIndex [c - 1];
+	set->firstIndex [0] = 0;
+
+	set->onlyFirst = -1;
+	for (c = 0  ;  c <= UCHAR_MAX  ;  ++c)
+		if (set->firstIndex [c + 1] > set->firstIndex [c]  &&  used++ == 0)
+			set->onlyFirst = c;
+	if (used != 1)
+		set->onlyFirst = -1;
+}
+
+/* Finds, in a single pass over `line', which patterns of `set' may match it:
+ * those without a literal, and those whose literal occurs in the line. When
+ * all literals start with the same character, memchr() finds where to look.
+ */
+static void markCandidates (patternSet* const set, const vString* const line)
+{
+	const unsigned char* const s = (const unsigned char*) vStringValue (line);
+	const size_t length = vStringLength (line);
+	unsigned int remaining = set->filtered;
+	unsigned int i;
+	size_t pos;
+	for (i = 0  ;  i < set->count  ;  ++i)
+		set->candidate [i] = (boolean) (set->patterns [i].literal == NULL);
+	for (pos = 0  ;  remaining > 0  &&  pos < length  ;  ++pos)
+	{
+		unsigned int j, end;
+		if (set->onlyFirst >= 0)
+		{
+			const unsigned char* const next = (const unsigned char*)
+					memchr (s + pos, set->onlyFirst, length - pos);
+			if (next == NULL)
+				break;
+			pos = next - s;
+		}
+		end = set->firstIndex [s [pos] + 1];
+		for (j = set->firstIndex [s [pos]]  ;  j < end  ;  ++j)
+		{
+			const unsigned int k = set->byFirst [j];
+			const regexPattern* const p = set->patterns + k;
+			if (! set->candidate [k]  &&  p->literalLength <= length - pos  &&
+				isLiteralAt (p, s + pos))
+			{
+				set->candidate [k] = TRUE;
+				--remaining;
+			}
+		}
+	}
+}
+
 #endif
 
 /* PUBLIC INTERFACE */
@@ -519,10 +900,13 @@ extern boolean matchRegex (const vString* const line, const langType language)
 	if (language != LANG_IGNORE  &&  language <= SetUpper  &&
 		Sets [language].count > 0)
 	{
-		const patternSet* const set = Sets + language;
+		patternSet* const set = Sets + language;
 		unsigned int i;
+		if (set->firstIndex == NULL)
+			buildPrefilter (set);
+		markCandidates (set, line);
 		for (i = 0  ;  i < set->count  ;  ++i)
-			if (matchRegexPattern (line, set->patterns + i))
+			if (set->candidate [i]  &&  matchRegexPattern (line, set->patterns + i))
 				result = TRUE;
 	}
 	return result;
@@ -549,14 +933,16 @@ extern void addTagRegex (
 	Assert (name != NULL);
 	if (! regexBroken)
 	{
-		regex_t* const cp = compileRegex (regex, flags);
+		char* literal;
+		boolean folded;
+		regex_t* const cp = compileRegex (regex, flags, &literal, &folded);
 		if (cp != NULL)
 		{
 			char kind;
 			char* kindName;
 			char* description;
 			parseKinds (kinds, &kind, &kindName, &description);
-			addCompiledTagPattern (language, cp, eStrdup (name),
+			addCompiledTagPattern (language, cp, literal, folded, eStrdup (name),
 					kind, kindName, description);
 		}
 	}
@@ -573,9 +959,11 @@ extern void addCallbackRegex (
 	Assert (regex != NULL);
 	if (! regexBroken)
 	{
-		regex_t* const cp = compileRegex (regex, flags);
+		char* literal;
+		boolean folded;
+		regex_t* const cp = compileRegex (regex, flags, &literal, &folded);
 		if (cp != NULL)
-			addCompiledCallbackPattern (language, cp, callback);
+			addCompiledCallbackPattern (language, cp, literal, folded, callback);
 	}
 #endif
 }
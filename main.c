@@ -75,11 +75,48 @@
 # include <io.h>  /* to declare _findfirst() */
 #endif
 
+/*  To parse files concurrently in worker processes.
+ */
+#ifdef JOBS_SUPPORTED
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# include <sys/wait.h>
+# ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+#endif
+
+/*  To recurse into directories relative to their open descriptors.
+ */
+#if defined (HAVE_OPENDIR) && defined (HAVE_FDOPENDIR) && defined (HAVE_OPENAT) && defined (HAVE_FSTATAT) && defined (HAVE_FCNTL_H) && defined (HAVE_SYS_STAT_H)
+# define RECURSE_USING_OPENAT
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# include <sys/stat.h>
+# include <fcntl.h>
+# ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+#endif
+
+/*  To read directories in a separate process while parsing the files found.
+ */
+#if defined (RECURSE_USING_OPENAT) && defined (JOBS_SUPPORTED)
+# define WALK_AHEAD
+#endif
+
 
 #include "debug.h"
+#include "entry.h"
+#include "gitindex.h"
+#include "ignorefile.h"
 #include "keyword.h"
 #include "main.h"
+#include "manifest.h"
 #include "options.h"
+#include "parse.h"
 #include "read.h"
 #include "routines.h"
 
@@ -91,7 +128,71 @@
 /*
 *   DATA DEFINITIONS
 */
-static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
+static struct { long files, lines, bytes, rescans; } Totals = { 0, 0, 0, 0 };
+
+#ifdef RECURSE_USING_OPENAT
+/*  Identities of the directories being recursed into and of those
+ *  containing them, against which to detect recursive links.
+ */
+typedef struct sDirectoryId {
+	dev_t dev;
+	ino_t ino;
+} directoryId;
+
+static struct {
+	directoryId *ids;
+	unsigned int count, max;
+} Ancestors = { NULL, 0, 0 };
+#endif
+
+/*  State of the listing of the files of a git working tree.
+ */
+typedef struct sGitWalk {
+	const char *dirName;  /* top of the working tree */
+	vString *fileName;
+	vString *checked;     /* directory of the previous file, not excluded */
+	vString *excluded;    /* excluded directory, with a trailing '/' */
+} gitWalk;
+
+#ifdef WALK_AHEAD
+/*  What the process reading directories reports for each file found,
+ *  followed by the name of the file.
+ */
+typedef struct sFoundFile {
+	boolean hasStatus;
+	unsigned long size;
+	unsigned long mtime;
+	size_t length;
+} foundFile;
+
+/*  Where the files found are reported, in the process reading directories.
+ */
+static FILE *FoundFiles = NULL;
+#endif
+
+#ifdef JOBS_SUPPORTED
+/*  Source files waiting to be handed out to worker processes.
+ */
+typedef struct sQueuedFile {
+	char *name;
+	unsigned long size;
+} queuedFile;
+
+static struct {
+	queuedFile *files;
+	unsigned int count, max;
+} Queue = { NULL, 0, 0 };
+
+/*  What a worker process reports back to its parent when done.
+ */
+typedef struct sJobResult {
+	boolean ok;
+	long tagBytes;
+	unsigned long tags;
+	struct sMax max;
+	long files, lines, bytes, rescans;
+} jobResult;
+#endif
 
 #ifdef AMIGA
 # include "ctags.h"
@@ -107,7 +208,10 @@ static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
 /*
 *   FUNCTION PROTOTYPES
 */
-static boolean createTagsForEntry (const char *const entryName);
+static void createTagsForEntry (const char *const entryName);
+static void createTagsForPath (
+		const char *const entryName, const boolean useIgnoreFiles);
+static void createTagsForFile (const char *const fileName, const fileStatus *const status);
 
 /*
 *   FUNCTION DEFINITIONS
@@ -122,6 +226,13 @@ extern void addTotals (
 	Totals.bytes += bytes;
 }
 
+/*  Counts a source file parsed again because a parser failed on it.
+ */
+extern void addRescan (void)
+{
+	++Totals.rescans;
+}
+
 extern boolean isDestinationStdout (void)
 {
 	boolean toStdout = FALSE;
@@ -138,16 +249,361 @@ extern boolean isDestinationStdout (void)
 	return toStdout;
 }
 
-#if defined (HAVE_OPENDIR)
-static boolean recurseUsingOpendir (const char *const dirName)
+/*  Tags a file found while reading directories or listed from a git index
+ *  or, in the process reading directories ahead, reports it to be tagged.
+ */
+static void reportFoundFile (
+		const char *const fileName, const fileStatus *const status)
+{
+#ifdef WALK_AHEAD
+	if (FoundFiles != NULL)
+	{
+		foundFile found;
+
+		memset (&found, 0, sizeof (found));
+		found.hasStatus = (boolean) (status != NULL);
+		if (status != NULL)
+		{
+			found.size = status->size;
+			found.mtime = status->mtime;
+		}
+		found.length = strlen (fileName);
+		if (fwrite (&found, sizeof (found), 1, FoundFiles) != 1  ||
+			fwrite (fileName, 1, found.length, FoundFiles) != found.length)
+		{
+			error (WARNING | PERROR, "cannot report files found");
+			_exit (1);
+		}
+	}
+	else
+#endif
+		createTagsForFile (fileName, status);
+}
+
+#if defined (RECURSE_USING_OPENAT)
+
+static boolean isAncestorDirectory (const struct stat *const status)
+{
+	boolean result = FALSE;
+	unsigned int i;
+	for (i = 0  ;  i < Ancestors.count  &&  ! result  ;  ++i)
+		result = (boolean) (Ancestors.ids [i].dev == status->st_dev  &&
+				Ancestors.ids [i].ino == status->st_ino);
+	return result;
+}
+
+static void pushAncestor (const struct stat *const status)
+{
+	if (Ancestors.count == Ancestors.max)
+	{
+		Ancestors.max = (Ancestors.max == 0) ? 32 : 2 * Ancestors.max;
+		Ancestors.ids = xRealloc (Ancestors.ids, Ancestors.max, directoryId);
+	}
+	Ancestors.ids [Ancestors.count].dev = status->st_dev;
+	Ancestors.ids [Ancestors.count].ino = status->st_ino;
+	++Ancestors.count;
+}
+
+/*  Records the directories above the one named, those which
+ *  isRecursiveLink () compares a link against.
+ */
+static void pushParentDirectories (const char *const dirName)
+{
+	char* const path = absoluteFilename (dirName);
+	while (strlen (path) > (size_t) 1  &&
+			path [strlen (path) - 1] == PATH_SEPARATOR)
+		path [strlen (path) - 1] = '\0';
+	while (strlen (path) > (size_t) 1)
+	{
+		char *const separator = strrchr (path, PATH_SEPARATOR);
+		struct stat status;
+		if (separator == NULL)
+			break;
+		else if (separator == path)  /* backed up to root directory */
+			*(separator + 1) = '\0';
+		else
+			*separator = '\0';
+		if (stat (path, &status) == 0)
+			pushAncestor (&status);
+	}
+	eFree (path);
+}
+
+static void recurseIntoSubdirectory (
+		const int parentFd, const char *const name, const char *const dirName);
+
+/*  Entries of a directory are examined relative to its descriptor `dirFd'
+ *  and, where the directory reports their type, not examined at all unless
+ *  needed.
+ */
+static void createTagsForEntryAt (
+		const int dirFd, const struct dirent *const entry,
+		const char *const fileName)
+{
+	const char *const name = entry->d_name;
+
+	if (isExcludedFile (fileName))
+		verbose ("excluding \"%s\"\n", fileName);
+#ifdef DT_UNKNOWN
+	else if (entry->d_type != DT_UNKNOWN  &&  entry->d_type != DT_LNK  &&
+			isIgnoredByFiles (fileName, (boolean) (entry->d_type == DT_DIR)))
+		verbose ("ignoring \"%s\" (ignore file)\n", fileName);
+	else if (entry->d_type == DT_DIR)
+		recurseIntoSubdirectory (dirFd, name, fileName);
+	else if (entry->d_type == DT_REG  &&  ! Option.incremental  &&
+			! (Option.jobs > 1  &&  ! Option.filter))
+		reportFoundFile (fileName, NULL);
+	else if (entry->d_type == DT_LNK  &&  ! Option.followLinks)
+		verbose ("ignoring \"%s\" (symbolic link)\n", fileName);
+	else if (entry->d_type != DT_UNKNOWN  &&
+			entry->d_type != DT_REG  &&  entry->d_type != DT_LNK)
+		verbose ("ignoring \"%s\" (special file)\n", fileName);
+#endif
+	else
+	{
+		fileStatus *const status = eStatAt (dirFd, name, fileName);
+		if (status->isSymbolicLink  &&  ! Option.followLinks)
+			verbose ("ignoring \"%s\" (symbolic link)\n", fileName);
+		else if (! status->exists)
+			error (WARNING | PERROR, "cannot open source file \"%s\"", fileName);
+		else if (isIgnoredByFiles (fileName, status->isDirectory))
+			verbose ("ignoring \"%s\" (ignore file)\n", fileName);
+		else if (status->isDirectory)
+			recurseIntoSubdirectory (dirFd, name, fileName);
+		else if (! status->isNormalFile)
+			verbose ("ignoring \"%s\" (special file)\n", fileName);
+		else
+			reportFoundFile (fileName, status);
+		eStatFree (status);
+	}
+}
+
+static void recurseUsingOpenat (
+		const int fd, const struct stat *const status,
+		const char *const dirName)
+{
+	DIR *const dir = fdopendir (fd);
+	if (dir == NULL)
+	{
+		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
+		close (fd);
+	}
+	else
+	{
+		const boolean isCurrent = (boolean) (strcmp (dirName, ".") == 0);
+		const boolean terminated = (boolean) (
+				dirName [strlen (dirName) - 1] == PATH_SEPARATOR);
+		vString *const filePath = vStringNew ();
+		struct dirent *entry;
+
+		pushAncestor (status);
+		if (Option.ignoreFiles)
+			pushIgnoreFiles (dirName, isCurrent ? 0 :
+					strlen (dirName) + (terminated ? 0 : 1));
+		while ((entry = readdir (dir)) != NULL)
+		{
+			if (strcmp (entry->d_name, ".") != 0  &&
+				strcmp (entry->d_name, "..") != 0)
+			{
+				vStringClear (filePath);
+				if (! isCurrent)
+				{
+					vStringCatS (filePath, dirName);
+					if (! terminated)
+						vStringPut (filePath, OUTPUT_PATH_SEPARATOR);
+				}
+				vStringCatS (filePath, entry->d_name);
+				createTagsForEntryAt (dirfd (dir), entry, vStringValue (filePath));
+			}
+		}
+		if (Option.ignoreFiles)
+			popIgnoreFiles ();
+		--Ancestors.count;
+		vStringDelete (filePath);
+		closedir (dir);
+	}
+}
+
+static boolean recurseUsingGitIndex (const char *const dirName);
+
+static void recurseIntoSubdirectory (
+		const int parentFd, const char *const name, const char *const dirName)
+{
+	const int fd = openat (parentFd, name, O_RDONLY | O_DIRECTORY);
+	struct stat status;
+
+	if (fd < 0  ||  fstat (fd, &status) != 0)
+	{
+		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
+		if (fd >= 0)
+			close (fd);
+	}
+	else if (isAncestorDirectory (&status))
+	{
+		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
+		close (fd);
+	}
+	else if (Option.gitIndex  &&  recurseUsingGitIndex (dirName))
+		close (fd);  /* the top of a nested git working tree */
+	else
+	{
+		verbose ("RECURSING into directory \"%s\"\n", dirName);
+		recurseUsingOpenat (fd, &status, dirName);
+	}
+}
+
+/*  Reads the directory tree open as `fd'. A submodule of a git working
+ *  tree found while reading another directory tree is read as part of it.
+ */
+static void walkDirectory (
+		const int fd, const struct stat *const status,
+		const char *const dirName)
+{
+	const boolean nested = (boolean) (Ancestors.count > 0);
+
+	if (! nested)
+		pushParentDirectories (dirName);
+	recurseUsingOpenat (fd, status, dirName);
+	if (! nested)
+	{
+		Ancestors.count = 0;
+		if (Ancestors.ids != NULL)
+			eFree (Ancestors.ids);
+		Ancestors.ids = NULL;
+		Ancestors.max = 0;
+	}
+}
+
+#ifdef WALK_AHEAD
+static void tagFilesFound (FILE *const fp)
+{
+	vString *const fileName = vStringNew ();
+	fileStatus status;
+	foundFile found;
+
+	memset (&status, 0, sizeof (status));
+	status.exists = TRUE;
+	status.isNormalFile = TRUE;
+	while (fread (&found, sizeof (found), 1, fp) == 1)
+	{
+		size_t i;
+		int c = 0;
+
+		vStringClear (fileName);
+		for (i = 0  ;  i < found.length  &&  (c = getc (fp)) != EOF  ;  ++i)
+			vStringPut (fileName, c);
+		vStringTerminate (fileName);
+		status.name = vStringValue (fileName);
+		status.size = found.size;
+		status.mtime = found.mtime;
+		createTagsForFile (vStringValue (fileName),
+				found.hasStatus ? &status : NULL);
+	}
+	vStringDelete (fileName);
+}
+
+/*  Tags the files found in the directory open as `fd' while a child process
+ *  keeps reading the directory tree ahead, so that the latency of reading
+ *  directories overlaps with parsing. The child reports the files found
+ *  through a pipe, whose capacity bounds how far ahead it may run, in the
+ *  order in which they would otherwise have been tagged. The messages of
+ *  both processes would interleave unpredictably, so this is not done when
+ *  verbose, nor by the child for the submodules it finds. Returns FALSE if
+ *  the directory still has to be read.
+ */
+static boolean walkAhead (
+		const int fd, const struct stat *const status,
+		const char *const dirName)
+{
+	boolean result = FALSE;
+	int fds [2];
+	pid_t pid = -1;
+
+	if (! Option.verbose  &&  FoundFiles == NULL)
+	{
+		if (TagFile.fp != NULL)
+			fflush (TagFile.fp);
+		fflush (stdout);
+		fflush (errout);
+		if (pipe (fds) == 0)
+		{
+			pid = fork ();
+			if (pid < 0)
+			{
+				close (fds [0]);
+				close (fds [1]);
+			}
+		}
+	}
+	if (pid == 0)
+	{
+		boolean ok;
+
+		close (fds [0]);
+		FoundFiles = fdopen (fds [1], "wb");
+		if (FoundFiles == NULL)
+			_exit (1);
+		walkDirectory (fd, status, dirName);
+		ok = (boolean) (fclose (FoundFiles) == 0);
+		fflush (stdout);
+		fflush (errout);
+		_exit (ok ? 0 : 1);
+	}
+	else if (pid > 0)
+	{
+		FILE *const fp = fdopen (fds [0], "rb");
+		int waitStatus = 0;
+
+		close (fds [1]);
+		close (fd);
+		if (fp == NULL)
+			error (FATAL | PERROR, "cannot read files found");
+		tagFilesFound (fp);
+		fclose (fp);
+		if (waitpid (pid, &waitStatus, 0) != pid  ||
+			! WIFEXITED (waitStatus)  ||  WEXITSTATUS (waitStatus) != 0)
+			error (FATAL, "directory reading process failed");
+		result = TRUE;
+	}
+	return result;
+}
+#endif
+
+static void recurseFromDirectory (const char *const dirName)
+{
+	const int fd = open (dirName, O_RDONLY | O_DIRECTORY);
+	struct stat status;
+
+	if (fd < 0  ||  fstat (fd, &status) != 0)
+	{
+		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
+		if (fd >= 0)
+			close (fd);
+	}
+#ifdef WALK_AHEAD
+	else if (walkAhead (fd, &status, dirName))
+		;
+#endif
+	else
+		walkDirectory (fd, &status, dirName);
+}
+
+#elif defined (HAVE_OPENDIR)
+static void recurseUsingOpendir (const char *const dirName)
 {
-	boolean resize = FALSE;
 	DIR *const dir = opendir (dirName);
 	if (dir == NULL)
 		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
 	else
 	{
 		struct dirent *entry;
+		if (Option.ignoreFiles)
+		{
+			vString *const prefix = combinePathAndFile (dirName, "");
+			pushIgnoreFiles (dirName, (strcmp (dirName, ".") == 0) ? 0 :
+					vStringLength (prefix));
+			vStringDelete (prefix);
+		}
 		while ((entry = readdir (dir)) != NULL)
 		{
 			if (strcmp (entry->d_name, ".") != 0  &&
@@ -158,37 +614,35 @@ static boolean recurseUsingOpendir (const char *const dirName)
 					filePath = vStringNewInit (entry->d_name);
 				else
 					filePath = combinePathAndFile (dirName, entry->d_name);
-				resize |= createTagsForEntry (vStringValue (filePath));
+				createTagsForEntry (vStringValue (filePath));
 				vStringDelete (filePath);
 			}
 		}
+		if (Option.ignoreFiles)
+			popIgnoreFiles ();
 		closedir (dir);
 	}
-	return resize;
 }
 
 #elif defined (HAVE_FINDFIRST) || defined (HAVE__FINDFIRST)
 
-static boolean createTagsForWildcardEntry (
+static void createTagsForWildcardEntry (
 		const char *const pattern, const size_t dirLength,
 		const char *const entryName)
 {
-	boolean resize = FALSE;
 	/* we must not recurse into the directories "." or ".." */
 	if (strcmp (entryName, ".") != 0  &&  strcmp (entryName, "..") != 0)
 	{
 		vString *const filePath = vStringNew ();
 		vStringNCopyS (filePath, pattern, dirLength);
 		vStringCatS (filePath, entryName);
-		resize = createTagsForEntry (vStringValue (filePath));
+		createTagsForEntry (vStringValue (filePath));
 		vStringDelete (filePath);
 	}
-	return resize;
 }
 
-static boolean createTagsForWildcardUsingFindfirst (const char *const pattern)
+static void createTagsForWildcardUsingFindfirst (const char *const pattern)
 {
-	boolean resize = FALSE;
 	const size_t dirLength = baseFilename (pattern) - pattern;
 #if defined (HAVE_FINDFIRST)
 	struct ffblk fileInfo;
@@ -196,7 +650,7 @@ static boolean createTagsForWildcardUsingFindfirst (const char *const pattern)
 	while (result == 0)
 	{
 		const char *const entry = (const char *) fileInfo.ff_name;
-		resize |= createTagsForWildcardEntry (pattern, dirLength, entry);
+		createTagsForWildcardEntry (pattern, dirLength, entry);
 		result = findnext (&fileInfo);
 	}
 #elif defined (HAVE__FINDFIRST)
@@ -207,19 +661,17 @@ static boolean createTagsForWildcardUsingFindfirst (const char *const pattern)
 		do
 		{
 			const char *const entry = (const char *) fileInfo.name;
-			resize |= createTagsForWildcardEntry (pattern, dirLength, entry);
+			createTagsForWildcardEntry (pattern, dirLength, entry);
 		} while (_findnext (hFile, &fileInfo) == 0);
 		_findclose (hFile);
 	}
 #endif
-	return resize;
 }
 
 #elif defined (AMIGA)
 
-static boolean createTagsForAmigaWildcard (const char *const pattern)
+static void createTagsForAmigaWildcard (const char *const pattern)
 {
-	boolean resize = FALSE;
 	struct AnchorPath *const anchor =
 			(struct AnchorPath *) eMalloc ((size_t) ANCHOR_SIZE);
 	LONG result;
@@ -235,34 +687,143 @@ static boolean createTagsForAmigaWildcard (const char *const pattern)
 	result = MatchFirst ((UBYTE *) pattern, anchor);
 	while (result == 0)
 	{
-		resize |= createTagsForEntry ((char *) anchor->ap_Buf);
+		createTagsForEntry ((char *) anchor->ap_Buf);
 		result = MatchNext (anchor);
 	}
 	MatchEnd (anchor);
 	eFree (anchor);
-	return resize;
 }
 #endif
 
-static boolean recurseIntoDirectory (const char *const dirName)
+/*  Names `length' characters of the file `name' of a git working tree
+ *  whose top is `dirName', as recursing into it would have named it.
+ */
+static void makeGitFileName (
+		vString *const fileName, const char *const dirName,
+		const char *const name, const size_t length)
+{
+	vStringClear (fileName);
+	if (strcmp (dirName, ".") != 0)
+	{
+		vStringCatS (fileName, dirName);
+		if (dirName [strlen (dirName) - 1] != PATH_SEPARATOR)
+			vStringPut (fileName, OUTPUT_PATH_SEPARATOR);
+	}
+	vStringNCatS (fileName, name, length);
+}
+
+/*  Determines whether a directory containing the file `name' is excluded.
+ *  The index lists files sorted by name, so that the directories already
+ *  checked for the previous file need not be checked again, and the files
+ *  of an excluded directory follow each other.
+ */
+static boolean isGitDirectoryExcluded (gitWalk *const walk, const char *const name)
+{
+	boolean result = FALSE;
+	const char *separator;
+
+	if (vStringLength (walk->excluded) > 0  &&  strncmp (name,
+			vStringValue (walk->excluded), vStringLength (walk->excluded)) == 0)
+		result = TRUE;
+	for (separator = strchr (name, '/')  ;  ! result  &&  separator != NULL  ;
+			separator = strchr (separator + 1, '/'))
+	{
+		const size_t length = separator - name;
+		const char *const checked = vStringValue (walk->checked);
+
+		if (vStringLength (walk->checked) >= length  &&
+			strncmp (checked, name, length) == 0  &&
+			(checked [length] == '/'  ||  checked [length] == '\0'))
+			continue;
+		makeGitFileName (walk->fileName, walk->dirName, name, length);
+		if (isExcludedFile (vStringValue (walk->fileName)))
+		{
+			verbose ("excluding \"%s\"\n", vStringValue (walk->fileName));
+			vStringNCopyS (walk->excluded, name, length + 1);
+			result = TRUE;
+		}
+	}
+	if (! result)
+	{
+		const char *const last = strrchr (name, '/');
+		vStringNCopyS (walk->checked, name, (last == NULL) ? 0 : last - name);
+	}
+	return result;
+}
+
+static void createTagsForGitEntry (
+		const char *const name, const gitEntryType type,
+		const unsigned long size, void *const data)
+{
+	gitWalk *const walk = (gitWalk *) data;
+
+	if (! isGitDirectoryExcluded (walk, name))
+	{
+		const char *fileName;
+
+		makeGitFileName (walk->fileName, walk->dirName, name, strlen (name));
+		fileName = vStringValue (walk->fileName);
+		if (type != GIT_ENTRY_FILE  ||  Option.incremental)
+			createTagsForPath (fileName, FALSE);
+		else if (isExcludedFile (fileName))
+			verbose ("excluding \"%s\"\n", fileName);
+		else
+		{
+			/*  The size recorded in the index is only used to share files
+			 *  out between jobs, for which it need not be exact.
+			 */
+			fileStatus status;
+
+			memset (&status, 0, sizeof (status));
+			status.name = vStringValue (walk->fileName);
+			status.exists = TRUE;
+			status.isNormalFile = TRUE;
+			status.size = size;
+			reportFoundFile (fileName, &status);
+		}
+	}
+}
+
+/*  Tags the files tracked in the git working tree whose top is `dirName',
+ *  as listed in its index, instead of reading its directories. Returns
+ *  FALSE if there is no such index.
+ */
+static boolean recurseUsingGitIndex (const char *const dirName)
+{
+	gitWalk walk;
+	boolean result;
+
+	walk.dirName = dirName;
+	walk.fileName = vStringNew ();
+	walk.checked = vStringNew ();
+	walk.excluded = vStringNew ();
+	result = readGitIndex (dirName, createTagsForGitEntry, &walk);
+	vStringDelete (walk.fileName);
+	vStringDelete (walk.checked);
+	vStringDelete (walk.excluded);
+	return result;
+}
+
+static void recurseIntoDirectory (const char *const dirName)
 {
-	boolean resize = FALSE;
 	if (isRecursiveLink (dirName))
 		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
 	else if (! Option.recurse)
 		verbose ("ignoring \"%s\" (directory)\n", dirName);
-	else
+	else if (! Option.gitIndex  ||  ! recurseUsingGitIndex (dirName))
 	{
 		verbose ("RECURSING into directory \"%s\"\n", dirName);
-#if defined (HAVE_OPENDIR)
-		resize = recurseUsingOpendir (dirName);
+#if defined (RECURSE_USING_OPENAT)
+		recurseFromDirectory (dirName);
+#elif defined (HAVE_OPENDIR)
+		recurseUsingOpendir (dirName);
 #elif defined (HAVE_FINDFIRST) || defined (HAVE__FINDFIRST)
 		{
 			vString *const pattern = vStringNew ();
 			vStringCopyS (pattern, dirName);
 			vStringPut (pattern, OUTPUT_PATH_SEPARATOR);
 			vStringCatS (pattern, "*.*");
-			resize = createTagsForWildcardUsingFindfirst (vStringValue (pattern));
+			createTagsForWildcardUsingFindfirst (vStringValue (pattern));
 			vStringDelete (pattern);
 		}
 #elif defined (AMIGA)
@@ -275,17 +836,186 @@ static boolean recurseIntoDirectory (const char *const dirName)
 					vStringPut (pattern, '/');
 			}
 			vStringCatS (pattern, "#?");
-			resize = createTagsForAmigaWildcard (vStringValue (pattern));
+			createTagsForAmigaWildcard (vStringValue (pattern));
 			vStringDelete (pattern);
 		}
 #endif
 	}
-	return resize;
 }
 
-static boolean createTagsForEntry (const char *const entryName)
+#ifdef JOBS_SUPPORTED
+
+static void queueFile (const char *const fileName, const unsigned long size)
+{
+	if (Queue.count == Queue.max)
+	{
+		Queue.max = (Queue.max == 0) ? 64 : Queue.max * 2;
+		Queue.files = xRealloc (Queue.files, Queue.max, queuedFile);
+	}
+	Queue.files [Queue.count].name = eStrdup (fileName);
+	Queue.files [Queue.count].size = size;
+	++Queue.count;
+}
+
+/*  Runs in the worker process: parses files [first, last) into its own
+ *  temporary tag file, then reports back through the pipe and exits.
+ */
+static void runJob (
+		const unsigned int first, const unsigned int last,
+		FILE *const fp, const int fd)
+{
+	jobResult result;
+	unsigned int i;
+
+	memset (&result, 0, sizeof (result));
+	redirectTagFile (fp);
+	TagFile.numTags.added = 0;
+	Totals.files = Totals.lines = Totals.bytes = Totals.rescans = 0;
+
+	for (i = first  ;  i < last  ;  ++i)
+		parseFile (Queue.files [i].name);
+
+	result.tagBytes = ftell (fp);
+	result.ok = (boolean) (fclose (fp) == 0  &&  result.tagBytes >= 0);
+	result.tags = TagFile.numTags.added;
+	result.max = TagFile.max;
+	result.files = Totals.files;
+	result.lines = Totals.lines;
+	result.bytes = Totals.bytes;
+	result.rescans = Totals.rescans;
+	if (write (fd, &result, sizeof (result)) != (ssize_t) sizeof (result))
+		result.ok = FALSE;
+	close (fd);
+
+	/*  Only flush what this process wrote itself; flushing every stream
+	 *  could reposition descriptors shared with the parent.
+	 */
+	fflush (stdout);
+	fflush (errout);
+	_exit (result.ok ? 0 : 1);
+}
+
+/*  Parses the queued files using up to Option.jobs worker processes. Each
+ *  worker takes a contiguous run of the queue, so that the tags appended
+ *  to the tag file come out in the same order as a sequential run.
+ */
+static void parseQueuedFiles (void)
+{
+	unsigned int jobs = Option.jobs;
+	unsigned int i;
+
+	if (jobs > Queue.count)
+		jobs = Queue.count;
+	if (jobs <= 1)
+	{
+		for (i = 0  ;  i < Queue.count  ;  ++i)
+			parseFile (Queue.files [i].name);
+	}
+	else
+	{
+		pid_t *const pids = xMalloc (jobs, pid_t);
+		int *const fds = xMalloc (jobs, int);
+		FILE **const fps = xMalloc (jobs, FILE*);
+		char **const names = xMalloc (jobs, char*);
+		unsigned long total = 0, done = 0;
+		unsigned int first = 0, j;
+
+		for (i = 0  ;  i < Queue.count  ;  ++i)
+			total += Queue.files [i].size + 1;
+
+		fflush (TagFile.fp);
+		fflush (stdout);
+		fflush (errout);
+		for (j = 0  ;  j < jobs  ;  ++j)
+		{
+			/*  Split the queue into runs of roughly equal size in bytes,
+			 *  leaving at least one file for each remaining job.
+			 */
+			const unsigned long target = total / jobs * (j + 1);
+			unsigned int last = first + 1;
+			int fd [2];
+
+			done += Queue.files [first].size + 1;
+			while (last < Queue.count - (jobs - j - 1)  &&
+				   (j == jobs - 1  ||  done < target))
+			{
+				done += Queue.files [last].size + 1;
+				++last;
+			}
+			names [j] = NULL;
+			fps [j] = tempFile ("w+", &names [j]);
+			if (pipe (fd) != 0)
+				error (FATAL | PERROR, "cannot create pipe");
+			pids [j] = fork ();
+			if (pids [j] < 0)
+				error (FATAL | PERROR, "cannot create worker process");
+			else if (pids [j] == 0)
+			{
+				close (fd [0]);
+				runJob (first, last, fps [j], fd [1]);
+			}
+			close (fd [1]);
+			fds [j] = fd [0];
+			first = last;
+		}
+		Assert (first == Queue.count);
+
+		for (j = 0  ;  j < jobs  ;  ++j)
+		{
+			jobResult result;
+			int status = 0;
+
+			if (read (fds [j], &result, sizeof (result)) !=
+					(ssize_t) sizeof (result))
+				result.ok = FALSE;
+			close (fds [j]);
+			if (waitpid (pids [j], &status, 0) != pids [j]  ||
+				! WIFEXITED (status)  ||  WEXITSTATUS (status) != 0)
+				result.ok = FALSE;
+			if (! result.ok)
+				error (FATAL, "worker process failed");
+
+			if (result.tagBytes > 0)
+			{
+				rewind (fps [j]);
+				copyTagData (fps [j], result.tagBytes);
+			}
+			TagFile.numTags.added += result.tags;
+			if (result.max.line > TagFile.max.line)
+				TagFile.max.line = result.max.line;
+			if (result.max.tag > TagFile.max.tag)
+				TagFile.max.tag = result.max.tag;
+			if (result.max.file > TagFile.max.file)
+				TagFile.max.file = result.max.file;
+			Totals.files += result.files;
+			Totals.lines += result.lines;
+			Totals.bytes += result.bytes;
+			Totals.rescans += result.rescans;
+
+			fclose (fps [j]);
+			remove (names [j]);
+			eFree (names [j]);
+		}
+		eFree (pids);
+		eFree (fds);
+		eFree (fps);
+		eFree (names);
+	}
+	for (i = 0  ;  i < Queue.count  ;  ++i)
+		eFree (Queue.files [i].name);
+	Queue.count = 0;
+}
+
+#else
+# define parseQueuedFiles()
+#endif
+
+/*  Files listed from a git index are tracked, so that they are not checked
+ *  against ignore files whichever way they are tagged.
+ */
+static void createTagsForPath (
+		const char *const entryName, const boolean useIgnoreFiles)
 {
-	boolean resize = FALSE;
 	fileStatus *status = eStat (entryName);
 
 	Assert (entryName != NULL);
@@ -295,22 +1025,42 @@ static boolean createTagsForEntry (const char *const entryName)
 		verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
 	else if (! status->exists)
 		error (WARNING | PERROR, "cannot open source file \"%s\"", entryName);
+	else if (useIgnoreFiles  &&  isIgnoredByFiles (entryName, status->isDirectory))
+		verbose ("ignoring \"%s\" (ignore file)\n", entryName);
 	else if (status->isDirectory)
-		resize = recurseIntoDirectory (entryName);
+		recurseIntoDirectory (entryName);
 	else if (! status->isNormalFile)
 		verbose ("ignoring \"%s\" (special file)\n", entryName);
 	else
-		resize = parseFile (entryName);
+		reportFoundFile (entryName, status);
 
 	eStatFree (status);
-	return resize;
+}
+
+static void createTagsForEntry (const char *const entryName)
+{
+	createTagsForPath (entryName, TRUE);
+}
+
+/*  `status' is only needed for incremental updates and parallel jobs.
+ */
+static void createTagsForFile (
+		const char *const fileName, const fileStatus *const status)
+{
+	if (Option.incremental  &&  isSourceFileUnchanged (fileName, status))
+		verbose ("skipping \"%s\" (unchanged)\n", fileName);
+#ifdef JOBS_SUPPORTED
+	else if (Option.jobs > 1  &&  ! Option.filter)
+		queueFile (fileName, status->size);
+#endif
+	else
+		parseFile (fileName);
 }
 
 #ifdef MANUAL_GLOBBING
 
-static boolean createTagsForWildcardArg (const char *const arg)
+static void createTagsForWildcardArg (const char *const arg)
 {
-	boolean resize = FALSE;
 	vString *const pattern = vStringNewInit (arg);
 	char *patternS = vStringValue (pattern);
 
@@ -324,18 +1074,15 @@ static boolean createTagsForWildcardArg (const char *const arg)
 		vStringPut (pattern, OUTPUT_PATH_SEPARATOR);
 		vStringCatS (pattern, "*.*");
 	}
-	resize |= createTagsForWildcardUsingFindfirst (patternS);
+	createTagsForWildcardUsingFindfirst (patternS);
 #endif
 	vStringDelete (pattern);
-	return resize;
 }
 
 #endif
 
-static boolean createTagsForArgs (cookedArgs *const args)
+static void createTagsForArgs (cookedArgs *const args)
 {
-	boolean resize = FALSE;
-
 	/*  Generate tags for each argument on the command line.
 	 */
 	while (! cArgOff (args))
@@ -343,28 +1090,28 @@ static boolean createTagsForArgs (cookedArgs *const args)
 		const char *const arg = cArgItem (args);
 
 #ifdef MANUAL_GLOBBING
-		resize |= createTagsForWildcardArg (arg);
+		createTagsForWildcardArg (arg);
 #else
-		resize |= createTagsForEntry (arg);
+		createTagsForEntry (arg);
 #endif
 		cArgForth (args);
+		if (cArgIsOption (args))
+			parseQueuedFiles ();
 		parseOptions (args);
 	}
-	return resize;
 }
 
 /*  Read from an opened file a list of file names for which to generate tags.
  */
-static boolean createTagsFromFileInput (FILE *const fp, const boolean filter)
+static void createTagsFromFileInput (FILE *const fp, const boolean filter)
 {
-	boolean resize = FALSE;
 	if (fp != NULL)
 	{
 		cookedArgs *args = cArgNewFromLineFile (fp);
 		parseOptions (args);
 		while (! cArgOff (args))
 		{
-			resize |= createTagsForEntry (cArgItem (args));
+			createTagsForEntry (cArgItem (args));
 			if (filter)
 			{
 				if (Option.filterTerminator != NULL)
@@ -372,30 +1119,29 @@ static boolean createTagsFromFileInput (FILE *const fp, const boolean filter)
 				fflush (stdout);
 			}
 			cArgForth (args);
+			if (cArgIsOption (args))
+				parseQueuedFiles ();
 			parseOptions (args);
 		}
 		cArgDelete (args);
 	}
-	return resize;
 }
 
 /*  Read from a named file a list of file names for which to generate tags.
  */
-static boolean createTagsFromListFile (const char *const fileName)
+static void createTagsFromListFile (const char *const fileName)
 {
-	boolean resize;
 	Assert (fileName != NULL);
 	if (strcmp (fileName, "-") == 0)
-		resize = createTagsFromFileInput (stdin, FALSE);
+		createTagsFromFileInput (stdin, FALSE);
 	else
 	{
 		FILE *const fp = fopen (fileName, "r");
 		if (fp == NULL)
 			error (FATAL | PERROR, "cannot open list file \"%s\"", fileName);
-		resize = createTagsFromFileInput (fp, FALSE);
+		createTagsFromFileInput (fp, FALSE);
 		fclose (fp);
 	}
-	return resize;
 }
 
 #if defined (HAVE_CLOCK)
@@ -438,6 +1184,9 @@ static void printTotals (const clock_t *const timeStamps)
 	}
 #endif
 	fputc ('\n', errout);
+	if (Totals.rescans > 0)
+		fprintf (errout, "%ld file%s parsed again after a failed pass\n",
+				Totals.rescans, plural (Totals.rescans));
 
 	fprintf (errout, "%lu tag%s added to tag file",
 			TagFile.numTags.added, plural (TagFile.numTags.added));
@@ -469,7 +1218,6 @@ static boolean etagsInclude (void)
 static void makeTags (cookedArgs *args)
 {
 	clock_t timeStamps [3];
-	boolean resize = FALSE;
 	boolean files = (boolean)(! cArgOff (args) || Option.fileList != NULL
 							  || Option.filter);
 
@@ -491,25 +1239,26 @@ static void makeTags (cookedArgs *args)
 	if (! cArgOff (args))
 	{
 		verbose ("Reading command line arguments\n");
-		resize = createTagsForArgs (args);
+		createTagsForArgs (args);
 	}
 	if (Option.fileList != NULL)
 	{
 		verbose ("Reading list file\n");
-		resize = (boolean) (createTagsFromListFile (Option.fileList) || resize);
+		createTagsFromListFile (Option.fileList);
 	}
 	if (Option.filter)
 	{
 		verbose ("Reading filter input\n");
-		resize = (boolean) (createTagsFromFileInput (stdin, TRUE) || resize);
+		createTagsFromFileInput (stdin, TRUE);
 	}
 	if (! files  &&  Option.recurse)
-		resize = recurseIntoDirectory (".");
+		recurseIntoDirectory (".");
+	parseQueuedFiles ();
 
 	timeStamp (1);
 
 	if (! Option.filter)
-		closeTagFile (resize);
+		closeTagFile ();
 
 	timeStamp (2);
 
@@ -24,6 +24,7 @@
 *   FUNCTION PROTOTYPES
 */
 extern void addTotals (const unsigned int files, const long unsigned int lines, const long unsigned int bytes);
+extern void addRescan (void);
 extern boolean isDestinationStdout (void);
 extern int main (int argc, char **argv);
 
@@ -0,0 +1,376 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to maintain the manifest used by the
+*   --incremental option. The manifest lives next to the tag file and records,
+*   for every source file whose tags the tag file holds, the name under which
+*   it appears in the tag file along with its size, modification time and,
+*   when known, a hash of its contents. A later run uses it to tell which
+*   source files need to be parsed again.
+*
+*   Modification times only have a resolution of one second, so a file
+*   changed again within the second it was read can keep both its size and
+*   its time stamp. As git does for its index, the manifest records when the
+*   run which wrote it started; the contents of any file whose time stamp is
+*   not older than that are hashed and always compared.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdlib.h>  /* to declare strtoul () */
+#ifdef HAVE_TIME_H
+# include <time.h>
+#endif
+
+#include "debug.h"
+#include "entry.h"
+#include "manifest.h"
+#include "options.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define MANIFEST_SUFFIX   ".manifest"
+#define MANIFEST_HEADER   "!_CTAGS_MANIFEST\t2\t"
+#define HASH_INITIAL      2166136261UL  /* FNV-1a, truncated to 32 bits */
+#define HASH_PRIME        16777619UL
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum eFileState {
+	FILE_UNSEEN,     /* listed in manifest, not named in this run */
+	FILE_UNCHANGED,  /* named in this run; its tags are kept */
+	FILE_CHANGED     /* named in this run; parsed again */
+} fileState;
+
+typedef struct sManifestEntry {
+	struct sManifestEntry *next;
+	char *tagPath;
+	unsigned long size;
+	unsigned long mtime;
+	unsigned long hash;
+	boolean hashed;      /* is "hash" valid? */
+	fileState state;
+} manifestEntry;
+
+/*
+*   DATA DEFINITIONS
+*/
+static manifestEntry **Table = NULL;
+static unsigned int TableSize = 0;
+static unsigned int EntryCount = 0;
+static unsigned long ManifestStamp = 0;  /* start of run which wrote manifest */
+static unsigned long Stamp = 0;          /* start of this run */
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static unsigned long hashBytes (
+		unsigned long hash, const unsigned char *p, size_t length)
+{
+	while (length-- > 0)
+	{
+		hash ^= *p++;
+		hash = (hash * HASH_PRIME) & 0xffffffffUL;
+	}
+	return hash;
+}
+
+static unsigned int hashTagPath (const char *const tagPath)
+{
+	return (unsigned int) (hashBytes (HASH_INITIAL,
+			(const unsigned char *) tagPath, strlen (tagPath)) % TableSize);
+}
+
+/*  Computes the hash of the contents of a file, returning FALSE if it
+ *  cannot be read.
+ */
+static boolean hashFileContents (
+		const char *const fileName, unsigned long *const pHash)
+{
+	enum { BufferSize = 65536 };
+	FILE *const fp = fopen (fileName, "rb");
+	boolean result = FALSE;
+
+	if (fp != NULL)
+	{
+		unsigned char *const buffer = xMalloc (BufferSize, unsigned char);
+		unsigned long hash = HASH_INITIAL;
+		size_t count;
+
+		while ((count = fread (buffer, (size_t) 1, BufferSize, fp)) > 0)
+			hash = hashBytes (hash, buffer, count);
+		result = (boolean) (! ferror (fp));
+		*pHash = hash;
+		eFree (buffer);
+		fclose (fp);
+	}
+	return result;
+}
+
+static void growTable (void)
+{
+	manifestEntry **const oldTable = Table;
+	const unsigned int oldSize = TableSize;
+	unsigned int i;
+
+	TableSize = (TableSize == 0) ? 1024 : TableSize * 2;
+	Table = xCalloc (TableSize, manifestEntry*);
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		manifestEntry *entry = oldTable [i];
+		while (entry != NULL)
+		{
+			manifestEntry *const next = entry->next;
+			const unsigned int h = hashTagPath (entry->tagPath);
+			entry->next = Table [h];
+			Table [h] = entry;
+			entry = next;
+		}
+	}
+	if (oldTable != NULL)
+		eFree (oldTable);
+}
+
+static manifestEntry *findEntry (const char *const tagPath)
+{
+	manifestEntry *entry = NULL;
+
+	if (TableSize > 0)
+	{
+		entry = Table [hashTagPath (tagPath)];
+		while (entry != NULL  &&  strcmp (entry->tagPath, tagPath) != 0)
+			entry = entry->next;
+	}
+	return entry;
+}
+
+static manifestEntry *addEntry (char *const tagPath)
+{
+	manifestEntry *const entry = xCalloc (1, manifestEntry);
+	unsigned int h;
+
+	if (EntryCount >= TableSize)
+		growTable ();
+	h = hashTagPath (tagPath);
+	entry->tagPath = tagPath;
+	entry->state = FILE_UNSEEN;
+	entry->next = Table [h];
+	Table [h] = entry;
+	++EntryCount;
+	return entry;
+}
+
+static char *manifestName (const char *const tagFileName)
+{
+	char *const name = xMalloc (strlen (tagFileName) +
+			strlen (MANIFEST_SUFFIX) + 1, char);
+	strcpy (name, tagFileName);
+	strcat (name, MANIFEST_SUFFIX);
+	return name;
+}
+
+/*  Loads the manifest belonging to the tag file, returning whether one was
+ *  found. Any previously loaded manifest is discarded.
+ */
+extern boolean readManifest (const char *const tagFileName)
+{
+	char *const name = manifestName (tagFileName);
+	FILE *const fp = fopen (name, "r");
+	boolean result = FALSE;
+
+	freeManifest ();
+	if (fp != NULL)
+	{
+		vString *const vLine = vStringNew ();
+		const char *line = readLine (vLine, fp);
+
+		if (line != NULL  &&  strncmp (line, MANIFEST_HEADER,
+				strlen (MANIFEST_HEADER)) == 0)
+		{
+			result = TRUE;
+			ManifestStamp = strtoul (line + strlen (MANIFEST_HEADER), NULL, 10);
+			while ((line = readLine (vLine, fp)) != NULL)
+			{
+				char *p = (char *) line;
+				unsigned long size, mtime, hash = 0;
+				boolean hashed = FALSE;
+
+				size = strtoul (p, &p, 10);
+				if (*p++ != '\t')
+					continue;
+				mtime = strtoul (p, &p, 10);
+				if (*p++ != '\t')
+					continue;
+				if (*p == '-')
+					++p;
+				else
+				{
+					hash = strtoul (p, &p, 16);
+					hashed = TRUE;
+				}
+				if (*p++ != '\t')
+					continue;
+				vStringStripNewline (vLine);
+				if (*p != '\0'  &&  findEntry (p) == NULL)
+				{
+					manifestEntry *const entry = addEntry (eStrdup (p));
+					entry->size = size;
+					entry->mtime = mtime;
+					entry->hash = hash;
+					entry->hashed = hashed;
+				}
+			}
+		}
+		else
+			error (WARNING, "ignoring invalid manifest \"%s\"", name);
+		vStringDelete (vLine);
+		fclose (fp);
+	}
+	eFree (name);
+	return result;
+}
+
+static unsigned long currentTime (void)
+{
+#ifdef HAVE_TIME_H
+	return (unsigned long) time (NULL);
+#else
+	return ~0UL;  /* treat every file as possibly changed unnoticed */
+#endif
+}
+
+/*  Records the current state of a source file about to be tagged and
+ *  returns whether its tags in the tag file are still up to date.
+ */
+extern boolean isSourceFileUnchanged (
+		const char *const fileName, const fileStatus *const status)
+{
+	char *const tagPath = makeSourceFileTagPath (fileName);
+	manifestEntry *entry = findEntry (tagPath);
+
+	if (Stamp == 0)
+		Stamp = currentTime ();
+	if (entry == NULL)
+	{
+		entry = addEntry (tagPath);
+		entry->state = FILE_CHANGED;
+	}
+	else
+	{
+		eFree (tagPath);
+		if (entry->state != FILE_UNSEEN)
+			return (boolean) (entry->state == FILE_UNCHANGED);
+		if (entry->size == status->size  &&  entry->mtime == status->mtime  &&
+			entry->mtime < ManifestStamp)
+			entry->state = FILE_UNCHANGED;
+		else
+		{
+			/*  A file whose time stamp changed but not its size may still
+			 *  have the same contents, and one whose time stamp is not older
+			 *  than the manifest may have changed without it changing.
+			 */
+			unsigned long hash = 0;
+			const boolean hashed = (boolean) (entry->size == status->size  &&
+					hashFileContents (fileName, &hash));
+
+			if (hashed  &&  entry->hashed  &&  hash == entry->hash)
+				entry->state = FILE_UNCHANGED;
+			else
+				entry->state = FILE_CHANGED;
+			entry->hash = hash;
+			entry->hashed = hashed;
+		}
+	}
+	/*  The next run will need the hash of a file it cannot trust the time
+	 *  stamp of.
+	 */
+	if (status->mtime >= Stamp  &&  ! entry->hashed)
+		entry->hashed = hashFileContents (fileName, &entry->hash);
+	entry->size = status->size;
+	entry->mtime = status->mtime;
+	return (boolean) (entry->state == FILE_UNCHANGED);
+}
+
+/*  Returns whether tags in the tag file for "tagPath" are to be kept.
+ */
+extern boolean isCurrentTagPath (const char *const tagPath)
+{
+	const manifestEntry *const entry = findEntry (tagPath);
+	return (boolean) (entry != NULL  &&  entry->state == FILE_UNCHANGED);
+}
+
+/*  Writes the manifest for the files named in this run.
+ */
+extern void writeManifest (const char *const tagFileName)
+{
+	char *const name = manifestName (tagFileName);
+	FILE *const fp = fopen (name, "w");
+
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot write manifest \"%s\"", name);
+	else
+	{
+		unsigned int i;
+
+		if (Stamp == 0)
+			Stamp = currentTime ();
+		fprintf (fp, "%s%lu\n", MANIFEST_HEADER, Stamp);
+		for (i = 0  ;  i < TableSize  ;  ++i)
+		{
+			const manifestEntry *entry;
+			for (entry = Table [i]  ;  entry != NULL  ;  entry = entry->next)
+			{
+				if (entry->state == FILE_UNSEEN)
+					continue;
+				fprintf (fp, "%lu\t%lu\t", entry->size, entry->mtime);
+				if (entry->hashed)
+					fprintf (fp, "%lx", entry->hash);
+				else
+					putc ('-', fp);
+				fprintf (fp, "\t%s\n", entry->tagPath);
+			}
+		}
+		if (fclose (fp) != 0)
+			error (WARNING | PERROR, "cannot write manifest \"%s\"", name);
+	}
+	eFree (name);
+}
+
+extern void freeManifest (void)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < TableSize  ;  ++i)
+	{
+		manifestEntry *entry = Table [i];
+		while (entry != NULL)
+		{
+			manifestEntry *const next = entry->next;
+			eFree (entry->tagPath);
+			eFree (entry);
+			entry = next;
+		}
+	}
+	if (Table != NULL)
+		eFree (Table);
+	Table = NULL;
+	TableSize = 0;
+	EntryCount = 0;
+	ManifestStamp = 0;
+	Stamp = 0;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,30 @@
+/*
+*   $Id$
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to manifest.c
+*/
+#ifndef _MANIFEST_H
+#define _MANIFEST_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "routines.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean readManifest (const char *const tagFileName);
+extern boolean isSourceFileUnchanged (const char *const fileName, const fileStatus *const status);
+extern boolean isCurrentTagPath (const char *const tagPath);
+extern void writeManifest (const char *const tagFileName);
+extern void freeManifest (void);
+
+#endif  /* _MANIFEST_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -5,9 +5,9 @@
 # Created by: Maarten L. Hekkelman <maarten@hekkelman.com>
 
 HEADERS	= 
-	args.h ctags.h debug.h entry.h general.h get.h keyword.h 
-	main.h options.h parse.h parsers.h read.h routines.h sort.h 
-	strlist.h vstring.h mac.h
+	args.h ctags.h debug.h entry.h general.h get.h gitindex.h 
+	ignorefile.h keyword.h main.h manifest.h options.h parse.h 
+	parsers.h read.h routines.h sort.h strlist.h vstring.h mac.h
 
 SOURCES = 
 	args.c 
@@ -22,12 +22,15 @@ SOURCES = 
 	erlang.c 
 	fortran.c 
 	get.c 
+	gitindex.c 
+	ignorefile.c 
 	keyword.c 
 	lisp.c 
 	lregex.c 
 	lua.c 
 	main.c 
 	make.c 
+	manifest.c 
 	options.c 
 	parse.c 
 	pascal.c 
@@ -65,12 +68,15 @@ OBJ = 
 	erlang.o 
 	fortran.o 
 	get.o 
+	gitindex.o 
+	ignorefile.o 
 	keyword.o 
 	lisp.o 
 	lregex.o 
 	lua.o 
 	main.o 
 	make.o 
+	manifest.o 
 	options.o 
 	parse.o 
 	pascal.o 
@@ -35,9 +35,9 @@ LIBS =
 OBJEXT = o
 
 HEADERS = e_qdos.h \
-	args.h ctags.h debug.h entry.h general.h get.h keyword.h \
-	main.h options.h parse.h parsers.h read.h routines.h sort.h \
-	strlist.h vstring.h
+	args.h ctags.h debug.h entry.h general.h get.h gitindex.h \
+	ignorefile.h keyword.h main.h manifest.h options.h parse.h \
+	parsers.h read.h routines.h sort.h strlist.h vstring.h
 
 OBJECTS = qdos.$(OBJEXT) \
 	args.$(OBJEXT) \
@@ -52,12 +52,15 @@ OBJECTS = qdos.$(OBJEXT) \
 	erlang.$(OBJEXT) \
 	fortran.$(OBJEXT) \
 	get.$(OBJEXT) \
+	gitindex.$(OBJEXT) \
+	ignorefile.$(OBJEXT) \
 	keyword.$(OBJEXT) \
 	lisp.$(OBJEXT) \
 	lregex.$(OBJEXT) \
 	lua.$(OBJEXT) \
 	main.$(OBJEXT) \
 	make.$(OBJEXT) \
+	manifest.$(OBJEXT) \
 	options.$(OBJEXT) \
 	parse.$(OBJEXT) \
 	pascal.$(OBJEXT) \
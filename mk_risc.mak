@@ -8,11 +8,12 @@ CC    = $(GCC) $(OPT)
 
 # Object list
 OBJECTS = \
-	o.args o.asm o.asp o.awk o.beta o.clang o.cobol o.eiffel o.entry
-	o.erlang o.fortran o.get o.keyword o.lisp o.lregex o.lua o.main \
-	o.make o.options o.parse o.pascal o.perl o.php o.python o.read \
-	o.rexx o.routines o.ruby o.scheme o.sh o.slang o.sort o.strlist \
-	o.tcl o.verilog o.vim o.vstring o.yacc
+	o.args o.asm o.asp o.awk o.beta o.clang o.cobol o.eiffel o.entry \
+	o.erlang o.fortran o.get o.gitindex o.ignorefile o.keyword \
+	o.lisp o.lregex o.lua o.main o.make o.manifest o.options o.parse \
+	o.pascal o.perl o.php o.python o.read o.rexx o.routines o.ruby \
+	o.scheme o.sh o.slang o.sort o.strlist o.tcl o.verilog o.vim \
+	o.vstring o.yacc
 
 all: $(OBJECTS)
 	gcc -o ctags $(OBJECTS) RegEx:libregex
@@ -62,6 +63,12 @@ o.fortran:	c.fortran
 o.get:		c.get
 	$(CC) -c c.get -o o.get
 
+o.gitindex:	c.gitindex
+	$(CC) -c c.gitindex -o o.gitindex
+
+o.ignorefile:	c.ignorefile
+	$(CC) -c c.ignorefile -o o.ignorefile
+
 o.keyword:	c.keyword
 	$(CC) -c c.keyword -o o.keyword
 
@@ -80,6 +87,9 @@ o.main:		c.main
 o.make:		c.make
 	$(CC) -c c.make -o o.make
 
+o.manifest:	c.manifest
+	$(CC) -c c.manifest -o o.manifest
+
 o.options:	c.options
 	$(CC) -c c.options -o o.options
 
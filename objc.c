@@ -1104,6 +1104,8 @@ static void findObjcTags (void)
 	tempName = vStringNew ();
 	fullMethodName = vStringNew ();
 	prevIdent = vStringNew ();
+	parentType = K_INTERFACE;
+	comeAfter = NULL;
 
 	st.name = vStringNew ();
 	st.cp = fileReadLine ();
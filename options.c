@@ -78,6 +78,22 @@ typedef struct sOptionDescription {
 	const char *description;
 } optionDescription;
 
+/*  How a name found in the ignore list is to be treated.
+ */
+typedef enum {
+	IGNORE_NAME,        /* "name": ignore the name */
+	IGNORE_PARENS,      /* "name+": ignore the name and its parenthesis */
+	IGNORE_REPLACED     /* "name=replacement": replace the name */
+} ignoreMode;
+
+typedef struct sIgnoreEntry {
+	const char *name;         /* points into a token of the ignore list */
+	size_t length;
+	ignoreMode mode;
+	const char *replacement;  /* for IGNORE_REPLACED */
+	struct sIgnoreEntry *next;
+} ignoreEntry;
+
 typedef void (*parametricOptionHandler) (const char *const option, const char *const parameter);
 
 typedef const struct {
@@ -99,6 +115,16 @@ typedef const struct {
 static boolean NonOptionEncountered;
 static stringList *OptionFiles;
 static stringList* Excluded;
+static fileMatcher* ExcludedMatcher;  /* compiled from Excluded when needed */
+
+/*  Index of Option.ignore by name, built when needed.
+ */
+static struct {
+	ignoreEntry **buckets;
+	ignoreEntry *entries;
+	unsigned int size;   /* number of buckets, a power of 2 */
+	unsigned int count;
+} IgnoreIndex = { NULL, NULL, 0, 0 };
 static boolean FilesRequired = TRUE;
 static boolean SkipConfiguration;
 
@@ -154,6 +180,10 @@ optionValues Option = {
 	FALSE,      /* --tag-relative */
 	FALSE,      /* --totals */
 	FALSE,      /* --line-directives */
+	1,          /* --jobs */
+	FALSE,      /* --incremental */
+	FALSE,      /* --git-index */
+	FALSE,      /* --ignore-files */
 #ifdef DEBUG
 	0, 0        /* -D, -b */
 #endif
@@ -232,10 +262,22 @@ static optionDescription LongOptionDescription [] = {
 #else
  {0,"       Force output of specified tag file format [2]."},
 #endif
+ {1,"  --git-index=[yes|no]"},
+ {1,"       Recurse into git working trees by listing the files in their index [no]."},
  {1,"  --help"},
  {1,"       Print this option summary."},
  {1,"  --if0=[yes|no]"},
  {1,"       Should C code within #if 0 conditional branches be parsed [no]?"},
+ {1,"  --ignore-files=[yes|no]"},
+ {1,"       Skip what .gitignore and .ignore files ignore when recursing [no]."},
+ {1,"  --incremental=[yes|no]"},
+ {1,"       Only parse source files changed since the tag file was written [no]."},
+ {1,"  --jobs=number"},
+#ifdef JOBS_SUPPORTED
+ {1,"       Parse up to 'number' source files concurrently [1]."},
+#else
+ {1,"       Not supported on this platform."},
+#endif
  {1,"  --<LANG>-kinds=[+|-]kinds"},
  {1,"       Enable/disable tag kinds for language <LANG>."},
  {1,"  --langdef=name"},
@@ -519,6 +561,20 @@ extern void checkOptions (void)
 		if (isDestinationStdout ())
 			error (FATAL, "%s tags to stdout", notice);
 	}
+	if (Option.incremental)
+	{
+		notice = "incremental mode is not compatible with";
+		if (Option.etags  ||  Option.xref  ||  Option.filter  ||
+			Option.lineDirectives  ||  isDestinationStdout ())
+		{
+			error (WARNING, "%s %s", notice,
+				Option.etags ? "etags output" :
+				Option.xref ? "xref output" :
+				Option.filter ? "filter mode" :
+				Option.lineDirectives ? "line directives" : "tags to stdout");
+			Option.incremental = FALSE;
+		}
+	}
 	if (Option.filter)
 	{
 		notice = "filter mode";
@@ -529,6 +585,11 @@ extern void checkOptions (void)
 		}
 		if (Option.tagFileName != NULL)
 			error (WARNING, "%s ignores output tag file name", notice);
+		if (Option.jobs > 1)
+		{
+			error (WARNING, "%s disables parallel jobs", notice);
+			Option.jobs = 1;
+		}
 	}
 }
 
@@ -840,6 +901,8 @@ static void processExcludeOption (
 		const char *const option __unused__, const char *const parameter)
 {
 	const char *const fileName = parameter + 1;
+	fileMatcherDelete (ExcludedMatcher);
+	ExcludedMatcher = NULL;
 	if (parameter [0] == '\0')
 		freeList (&Excluded);
 	else if (parameter [0] == '@')
@@ -869,14 +932,17 @@ extern boolean isExcludedFile (const char* const name)
 	boolean result = FALSE;
 	if (Excluded != NULL)
 	{
-		result = stringListFileMatched (Excluded, base);
+		if (ExcludedMatcher == NULL)
+			ExcludedMatcher = fileMatcherNew (Excluded);
+		result = fileMatcherMatched (ExcludedMatcher, base);
 		if (! result  &&  name != base)
-			result = stringListFileMatched (Excluded, name);
+			result = fileMatcherMatched (ExcludedMatcher, name);
 	}
 #ifdef AMIGA
 	/* not a good solution, but the only one which works often */
 	if (! result)
-		result = (boolean) (strcmp (name, TagFile.name) == 0);
+		result = (boolean) (TagFile.name != NULL  &&
+				strcmp (name, TagFile.name) == 0);
 #endif
 	return result;
 }
@@ -996,6 +1062,21 @@ static void processFormatOption (
 		error (FATAL, "Unsupported value for \"%s\" option", option);
 }
 
+static void processJobsOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned int jobs;
+
+	if (sscanf (parameter, "%u", &jobs) < 1  ||  jobs == 0)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+#ifdef JOBS_SUPPORTED
+	Option.jobs = jobs;
+#else
+	if (jobs > 1)
+		error (WARNING, "%s option not supported on this host", option);
+#endif
+}
+
 static void printInvocationDescription (void)
 {
 	printf (INVOCATION, getExecutableName ());
@@ -1372,6 +1453,93 @@ static void processHeaderListOption (const int option, const char *parameter)
  *  Token ignore processing
  */
 
+static unsigned long hashIgnoreName (const char *const name, const size_t length)
+{
+	unsigned long hash = 2166136261UL;
+	size_t i;
+	for (i = 0  ;  i < length  ;  ++i)
+		hash = ((hash ^ (unsigned char) name [i]) * 16777619UL) & 0xffffffffUL;
+	return hash;
+}
+
+static const ignoreEntry* findIgnoreEntry (
+		const char *const name, const size_t length)
+{
+	const ignoreEntry *entry = IgnoreIndex.buckets [
+			hashIgnoreName (name, length) & (IgnoreIndex.size - 1)];
+
+	while (entry != NULL  &&  ! (entry->length == length  &&
+			memcmp (entry->name, name, length) == 0))
+		entry = entry->next;
+	return entry;
+}
+
+/*  Adds a name to the index unless an earlier token already covers it.
+ */
+static void addIgnoreEntry (
+		const char *const name, const size_t length,
+		const ignoreMode mode, const char *const replacement)
+{
+	if (findIgnoreEntry (name, length) == NULL)
+	{
+		ignoreEntry *const entry = &IgnoreIndex.entries [IgnoreIndex.count++];
+		ignoreEntry **const bucket = &IgnoreIndex.buckets [
+				hashIgnoreName (name, length) & (IgnoreIndex.size - 1)];
+
+		entry->name = name;
+		entry->length = length;
+		entry->mode = mode;
+		entry->replacement = replacement;
+		entry->next = *bucket;
+		*bucket = entry;
+	}
+}
+
+/*  Each token of the ignore list is indexed under every name it applies to,
+ *  the first token of the list applying to a name taking precedence.
+ */
+static void buildIgnoreIndex (void)
+{
+	const unsigned int count = stringListCount (Option.ignore);
+	unsigned int size = 16;
+	unsigned int i;
+
+	while (size < 6 * count)
+		size *= 2;
+	IgnoreIndex.buckets = xCalloc (size, ignoreEntry*);
+	IgnoreIndex.entries = (count == 0) ? NULL : xMalloc (3 * count, ignoreEntry);
+	IgnoreIndex.size = size;
+	IgnoreIndex.count = 0;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const vString *const token = stringListItem (Option.ignore, i);
+		const char *const name = vStringValue (token);
+		const size_t length = vStringLength (token);
+		const char *const equal = strchr (name, '=');
+
+		addIgnoreEntry (name, length, IGNORE_NAME, NULL);
+		if (length > 0  &&  name [length - 1] == '+')
+			addIgnoreEntry (name, length - 1, IGNORE_PARENS, NULL);
+		if (equal != NULL)
+			addIgnoreEntry (name, equal - name, IGNORE_REPLACED, equal + 1);
+	}
+}
+
+static void discardIgnoreIndex (void)
+{
+	if (IgnoreIndex.buckets != NULL)
+	{
+		eFree (IgnoreIndex.buckets);
+		if (IgnoreIndex.entries != NULL)
+			eFree (IgnoreIndex.entries);
+		IgnoreIndex.buckets = NULL;
+		IgnoreIndex.entries = NULL;
+		IgnoreIndex.size = 0;
+		IgnoreIndex.count = 0;
+	}
+}
+
 /*  Determines whether or not "name" should be ignored, per the ignore list.
  */
 extern boolean isIgnoreToken (
@@ -1382,39 +1550,32 @@ extern boolean isIgnoreToken (
 
 	if (Option.ignore != NULL)
 	{
-		const size_t nameLen = strlen (name);
-		unsigned int i;
+		const ignoreEntry *entry;
 
 		if (pIgnoreParens != NULL)
 			*pIgnoreParens = FALSE;
 
-		for (i = 0  ;  i < stringListCount (Option.ignore)  ;  ++i)
+		if (IgnoreIndex.buckets == NULL)
+			buildIgnoreIndex ();
+		entry = findIgnoreEntry (name, strlen (name));
+		if (entry != NULL)
 		{
-			vString *token = stringListItem (Option.ignore, i);
-
-			if (strncmp (vStringValue (token), name, nameLen) == 0)
+			switch (entry->mode)
 			{
-				const size_t tokenLen = vStringLength (token);
-
-				if (nameLen == tokenLen)
-				{
+				case IGNORE_NAME:
 					result = TRUE;
 					break;
-				}
-				else if (tokenLen == nameLen + 1  &&
-						vStringChar (token, tokenLen - 1) == '+')
-				{
+
+				case IGNORE_PARENS:
 					result = TRUE;
 					if (pIgnoreParens != NULL)
 						*pIgnoreParens = TRUE;
 					break;
-				}
-				else if (vStringChar (token, nameLen) == '=')
-				{
+
+				case IGNORE_REPLACED:
 					if (replacement != NULL)
-						*replacement = vStringValue (token) + nameLen + 1;
+						*replacement = entry->replacement;
 					break;
-				}
 			}
 		}
 	}
@@ -1423,6 +1584,7 @@ extern boolean isIgnoreToken (
 
 static void saveIgnoreToken (vString *const ignoreToken)
 {
+	discardIgnoreIndex ();
 	if (Option.ignore == NULL)
 		Option.ignore = stringListNew ();
 	stringListAdd (Option.ignore, ignoreToken);
@@ -1449,6 +1611,7 @@ static void addIgnoreListFromFile (const char *const fileName)
 	stringList* tokens = stringListNewFromFile (fileName);
 	if (tokens == NULL)
 		error (FATAL | PERROR, "cannot open \"%s\"", fileName);
+	discardIgnoreIndex ();
 	if (Option.ignore == NULL)
 		Option.ignore = tokens;
 	else
@@ -1468,6 +1631,7 @@ static void processIgnoreOption (const char *const list)
 #endif
 	else if (strcmp (list, "-") == 0)
 	{
+		discardIgnoreIndex ();
 		freeList (&Option.ignore);
 		verbose ("    clearing list\n");
 	}
@@ -1497,6 +1661,7 @@ static parametricOption ParametricOptions [] = {
 	{ "filter-terminator",      processFilterTerminatorOption,  TRUE    },
 	{ "format",                 processFormatOption,            TRUE    },
 	{ "help",                   processHelpOption,              TRUE    },
+	{ "jobs",                   processJobsOption,              TRUE    },
 	{ "lang",                   processLanguageForceOption,     FALSE   },
 	{ "language",               processLanguageForceOption,     FALSE   },
 	{ "language-force",         processLanguageForceOption,     FALSE   },
@@ -1517,7 +1682,10 @@ static booleanOption BooleanOptions [] = {
 	{ "file-scope",     &Option.include.fileScope,      FALSE   },
 	{ "file-tags",      &Option.include.fileNames,      FALSE   },
 	{ "filter",         &Option.filter,                 TRUE    },
+	{ "git-index",      &Option.gitIndex,               FALSE   },
 	{ "if0",            &Option.if0,                    FALSE   },
+	{ "ignore-files",   &Option.ignoreFiles,            FALSE   },
+	{ "incremental",    &Option.incremental,            TRUE    },
 	{ "kind-long",      &Option.kindLong,               TRUE    },
 	{ "line-directives",&Option.lineDirectives,         FALSE   },
 	{ "links",          &Option.followLinks,            FALSE   },
@@ -2032,7 +2200,10 @@ extern void freeOptionResources (void)
 	freeString (&Option.fileList);
 	freeString (&Option.filterTerminator);
 
+	fileMatcherDelete (ExcludedMatcher);
+	ExcludedMatcher = NULL;
 	freeList (&Excluded);
+	discardIgnoreIndex ();
 	freeList (&Option.ignore);
 	freeList (&Option.headerExt);
 	freeList (&Option.etagsInclude);
@@ -109,6 +109,10 @@ typedef struct sOptionValues {
 	boolean tagRelative;    /* --tag-relative file paths relative to tag file */
 	boolean printTotals;    /* --totals  print cumulative statistics */
 	boolean lineDirectives; /* --linedirectives  process #line directives */
+	unsigned int jobs;      /* --jobs  number of files parsed concurrently */
+	boolean incremental;    /* --incremental  only parse changed files */
+	boolean gitIndex;       /* --git-index  list git working trees from index */
+	boolean ignoreFiles;    /* --ignore-files  honor .gitignore and .ignore */
 #ifdef DEBUG
 	long debugLevel;        /* -D  debugging output */
 	unsigned long breakLine;/* -b  source line at which to call lineBreak() */
@@ -16,6 +16,10 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <ctype.h>  /* to define tolower () */
+#ifdef HAVE_FNMATCH_H
+# include <fnmatch.h>
+#endif
 
 #include "debug.h"
 #include "entry.h"
@@ -27,6 +31,49 @@
 #include "routines.h"
 #include "vstring.h"
 
+/*
+*   MACROS
+*/
+#ifdef CASE_INSENSITIVE_FILENAMES
+# define EXTENSIONS_FOLDED  TRUE
+#else
+# define EXTENSIONS_FOLDED  FALSE
+#endif
+#if ! defined (HAVE_FNMATCH)  &&  defined (CASE_INSENSITIVE_FILENAMES)
+# define NAMES_FOLDED  TRUE
+#else
+# define NAMES_FOLDED  FALSE
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  Maps a name taken from the language maps to the first language claiming it.
+ */
+typedef struct sNameEntry {
+	const char *name;  /* points into a language map */
+	langType language;
+	struct sNameEntry *next;
+} nameEntry;
+
+typedef struct sNameTable {
+	nameEntry **buckets;
+	nameEntry *entries;
+	unsigned int size;   /* number of buckets, a power of 2 */
+	unsigned int count;
+	boolean folded;      /* are names compared ignoring case? */
+} nameTable;
+
+/*  A file name pattern of a language map which is not a literal file name.
+ */
+typedef struct sPatternEntry {
+	const char *pattern;
+	const char *suffix;  /* literal suffix, if the pattern is "*" and it */
+	size_t suffixLength;
+	langType language;
+} patternEntry;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -34,6 +81,18 @@ static parserDefinitionFunc* BuiltInParsers[] = { PARSER_LIST };
 static parserDefinition** LanguageTable = NULL;
 static unsigned int LanguageCount = 0;
 
+/*  Index over the language maps of all languages, built when first needed
+ *  and discarded whenever a language map changes.
+ */
+static struct {
+	boolean valid;
+	nameTable extensions;      /* file name extensions */
+	nameTable names;           /* patterns which are literal file names */
+	patternEntry *patterns;    /* other patterns, in language order */
+	unsigned int patternCount;
+} MapIndex = { FALSE, { NULL, NULL, 0, 0, FALSE },
+		{ NULL, NULL, 0, 0, FALSE }, NULL, 0 };
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -92,29 +151,221 @@ extern langType getNamedLanguage (const char *const name)
 	return result;
 }
 
-static langType getExtensionLanguage (const char *const extension)
+/*
+*   Language map index
+*/
+
+static unsigned long hashName (const char *const name, const boolean folded)
+{
+	unsigned long hash = 2166136261UL;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *) name  ;  *p != '\0'  ;  ++p)
+	{
+		const int c = folded ? tolower ((int) *p) : (int) *p;
+		hash = ((hash ^ (unsigned long) c) * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
+
+static boolean isSameName (
+		const char *const name1, const char *const name2, const boolean folded)
+{
+	if (folded)
+		return (boolean) (strcasecmp (name1, name2) == 0);
+	else
+		return (boolean) (strcmp (name1, name2) == 0);
+}
+
+static langType lookupName (const nameTable *const table, const char *const name)
 {
 	langType result = LANG_IGNORE;
-	unsigned int i;
-	for (i = 0  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+
+	if (table->count > 0)
 	{
-		stringList* const exts = LanguageTable [i]->currentExtensions;
-		if (exts != NULL  &&  stringListExtensionMatched (exts, extension))
-			result = i;
+		const unsigned long hash = hashName (name, table->folded);
+		const nameEntry *entry = table->buckets [hash & (table->size - 1)];
+
+		for (  ;  entry != NULL  &&  result == LANG_IGNORE  ;  entry = entry->next)
+			if (isSameName (entry->name, name, table->folded))
+				result = entry->language;
+	}
+	return result;
+}
+
+static void initNameTable (
+		nameTable *const table, const unsigned int maxCount,
+		const boolean folded)
+{
+	unsigned int size = 16;
+
+	while (size < 2 * maxCount)
+		size *= 2;
+	table->buckets = xCalloc (size, nameEntry*);
+	table->entries = (maxCount == 0) ? NULL : xMalloc (maxCount, nameEntry);
+	table->size = size;
+	table->count = 0;
+	table->folded = folded;
+}
+
+/*  Adds a name unless an earlier language already claimed it.
+ */
+static void addName (
+		nameTable *const table, const char *const name,
+		const langType language)
+{
+	if (lookupName (table, name) == LANG_IGNORE)
+	{
+		const unsigned long hash = hashName (name, table->folded);
+		nameEntry *const entry = &table->entries [table->count++];
+		nameEntry **const bucket = &table->buckets [hash & (table->size - 1)];
+
+		entry->name = name;
+		entry->language = language;
+		entry->next = *bucket;
+		*bucket = entry;
+	}
+}
+
+static void freeNameTable (nameTable *const table)
+{
+	if (table->buckets != NULL)
+		eFree (table->buckets);
+	if (table->entries != NULL)
+		eFree (table->entries);
+	table->buckets = NULL;
+	table->entries = NULL;
+	table->size = 0;
+	table->count = 0;
+}
+
+static void discardMapIndex (void)
+{
+	if (MapIndex.valid)
+	{
+		freeNameTable (&MapIndex.extensions);
+		freeNameTable (&MapIndex.names);
+		if (MapIndex.patterns != NULL)
+			eFree (MapIndex.patterns);
+		MapIndex.patterns = NULL;
+		MapIndex.patternCount = 0;
+		MapIndex.valid = FALSE;
+	}
+}
+
+static boolean isLiteralPattern (const char *const pattern)
+{
+#ifdef HAVE_FNMATCH
+	return (boolean) (strpbrk (pattern, "*?[\\") == NULL);
+#else
+	return TRUE;
+#endif
+}
+
+static void addPattern (const char *const pattern, const langType language)
+{
+	patternEntry *const entry = &MapIndex.patterns [MapIndex.patternCount++];
+
+	entry->pattern = pattern;
+	entry->language = language;
+	if (pattern [0] == '*'  &&  isLiteralPattern (pattern + 1))
+	{
+		entry->suffix = pattern + 1;
+		entry->suffixLength = strlen (entry->suffix);
+	}
+	else
+	{
+		entry->suffix = NULL;
+		entry->suffixLength = 0;
+	}
+}
+
+static boolean isPatternMatched (
+		const patternEntry *const entry, const char *const fileName)
+{
+	boolean result;
+
+	if (entry->suffix != NULL)
+	{
+		const size_t length = strlen (fileName);
+		result = (boolean) (length >= entry->suffixLength  &&
+			strcmp (fileName + length - entry->suffixLength, entry->suffix) == 0);
+	}
+	else
+	{
+#ifdef HAVE_FNMATCH
+		result = (boolean) (fnmatch (entry->pattern, fileName, 0) == 0);
+#else
+		result = FALSE;  /* every pattern is literal */
+#endif
 	}
 	return result;
 }
 
+static void buildMapIndex (void)
+{
+	unsigned int extensionCount = 0, patternCount = 0;
+	unsigned int i, j;
+
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const parserDefinition* const lang = LanguageTable [i];
+		if (lang->currentExtensions != NULL)
+			extensionCount += stringListCount (lang->currentExtensions);
+		if (lang->currentPatterns != NULL)
+			patternCount += stringListCount (lang->currentPatterns);
+	}
+	initNameTable (&MapIndex.extensions, extensionCount, EXTENSIONS_FOLDED);
+	initNameTable (&MapIndex.names, patternCount, NAMES_FOLDED);
+	MapIndex.patterns = (patternCount == 0) ? NULL :
+			xMalloc (patternCount, patternEntry);
+	MapIndex.patternCount = 0;
+
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const parserDefinition* const lang = LanguageTable [i];
+		const stringList* const exts = lang->currentExtensions;
+		const stringList* const ptrns = lang->currentPatterns;
+
+		for (j = 0  ;  exts != NULL  &&  j < stringListCount (exts)  ;  ++j)
+			addName (&MapIndex.extensions,
+					vStringValue (stringListItem (exts, j)), (langType) i);
+		for (j = 0  ;  ptrns != NULL  &&  j < stringListCount (ptrns)  ;  ++j)
+		{
+			const char *const pattern = vStringValue (stringListItem (ptrns, j));
+			if (isLiteralPattern (pattern))
+				addName (&MapIndex.names, pattern, (langType) i);
+			else
+				addPattern (pattern, (langType) i);
+		}
+	}
+	MapIndex.valid = TRUE;
+}
+
+static langType getExtensionLanguage (const char *const extension)
+{
+	if (! MapIndex.valid)
+		buildMapIndex ();
+	return lookupName (&MapIndex.extensions, extension);
+}
+
 static langType getPatternLanguage (const char *const fileName)
 {
-	langType result = LANG_IGNORE;
 	const char* base = baseFilename (fileName);
+	langType result;
 	unsigned int i;
-	for (i = 0  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+
+	if (! MapIndex.valid)
+		buildMapIndex ();
+	result = lookupName (&MapIndex.names, base);
+
+	/*  A pattern of an earlier language takes precedence.
+	 */
+	for (i = 0  ;  i < MapIndex.patternCount  &&  (result == LANG_IGNORE  ||
+			MapIndex.patterns [i].language < result)  ;  ++i)
 	{
-		stringList* const ptrns = LanguageTable [i]->currentPatterns;
-		if (ptrns != NULL  &&  stringListFileMatched (ptrns, base))
-			result = i;
+		if (isPatternMatched (&MapIndex.patterns [i], base))
+			result = MapIndex.patterns [i].language;
 	}
 	return result;
 }
@@ -226,6 +477,7 @@ extern void installLanguageMapDefault (const langType language)
 	parserDefinition* lang;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	lang = LanguageTable [language];
+	discardMapIndex ();
 	if (lang->currentPatterns != NULL)
 		stringListDelete (lang->currentPatterns);
 	if (lang->currentExtensions != NULL)
@@ -263,6 +515,7 @@ extern void installLanguageMapDefaults (void)
 extern void clearLanguageMap (const langType language)
 {
 	Assert (0 <= language  &&  language < (int) LanguageCount);
+	discardMapIndex ();
 	stringListClear (LanguageTable [language]->currentPatterns);
 	stringListClear (LanguageTable [language]->currentExtensions);
 }
@@ -273,6 +526,7 @@ extern void addLanguagePatternMap (const langType language, const char* ptrn)
 	parserDefinition* lang;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	lang = LanguageTable [language];
+	discardMapIndex ();
 	if (lang->currentPatterns == NULL)
 		lang->currentPatterns = stringListNew ();
 	stringListAdd (lang->currentPatterns, str);
@@ -282,6 +536,7 @@ extern boolean removeLanguageExtensionMap (const char *const extension)
 {
 	boolean result = FALSE;
 	unsigned int i;
+	discardMapIndex ();
 	for (i = 0  ;  i < LanguageCount  &&  ! result ;  ++i)
 	{
 		stringList* const exts = LanguageTable [i]->currentExtensions;
@@ -300,6 +555,7 @@ extern void addLanguageExtensionMap (
 	vString* const str = vStringNewInit (extension);
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	removeLanguageExtensionMap (extension);
+	discardMapIndex ();
 	stringListAdd (LanguageTable [language]->currentExtensions, str);
 }
 
@@ -370,6 +626,7 @@ extern void initializeParsing (void)
 extern void freeParserResources (void)
 {
 	unsigned int i;
+	discardMapIndex ();
 	for (i = 0  ;  i < LanguageCount  ;  ++i)
 	{
 		parserDefinition* const lang = LanguageTable [i];
@@ -649,64 +906,64 @@ static rescanReason createTagsForFile (
 		const char *const fileName, const langType language,
 		const unsigned int passCount)
 {
+	const parserDefinition* const lang = LanguageTable [language];
 	rescanReason rescan = RESCAN_NONE;
-	Assert (0 <= language  &&  language < (int) LanguageCount);
-	if (fileOpen (fileName, language))
-	{
-		const parserDefinition* const lang = LanguageTable [language];
-		if (Option.etags)
-			beginEtagsFile ();
 
-		makeFileTag (fileName);
+	if (passCount > 1)
+		fileRewind ();
+	if (Option.etags)
+		beginEtagsFile ();
 
-		if (lang->parser != NULL)
-			lang->parser ();
-		else if (lang->parser2 != NULL)
-			rescan = lang->parser2 (passCount);
+	makeFileTag (fileName);
 
-		if (Option.etags)
-			endEtagsFile (getSourceFileTagPath ());
+	if (lang->parser != NULL)
+		lang->parser ();
+	else if (lang->parser2 != NULL)
+		rescan = lang->parser2 (passCount);
 
-		fileClose ();
-	}
+	if (Option.etags)
+		endEtagsFile (getSourceFileTagPath ());
 
 	return rescan;
 }
 
-static boolean createTagsWithFallback (
+/*  Parses a source file, going over it again as long as its parser asks for
+ *  it. The file is opened and loaded only once for all passes.
+ */
+static void createTagsWithFallback (
 		const char *const fileName, const langType language)
 {
 	unsigned long numTags	= TagFile.numTags.added;
-	fpos_t tagFilePosition;
+	size_t batchLength = vStringLength (TagFile.vBatch);
 	unsigned int passCount = 0;
-	boolean tagFileResized = FALSE;
 	rescanReason whyRescan;
 
-	fgetpos (TagFile.fp, &tagFilePosition);
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	if (! fileOpen (fileName, language))
+		return;
 	while ( ( whyRescan =
 	            createTagsForFile (fileName, language, ++passCount) )
 	                != RESCAN_NONE)
 	{
 		if (whyRescan == RESCAN_FAILED)
 		{
-			/*  Restore prior state of tag file.
+			/*  Discard the tags of the failed pass.
 			*/
-			fsetpos (TagFile.fp, &tagFilePosition);
+			vStringTruncate (TagFile.vBatch, batchLength);
 			TagFile.numTags.added = numTags;
-			tagFileResized = TRUE;
+			addRescan ();
 		}
 		else if (whyRescan == RESCAN_APPEND)
 		{
-			fgetpos(TagFile.fp, &tagFilePosition);
+			batchLength = vStringLength (TagFile.vBatch);
 			numTags = TagFile.numTags.added;
 		}
 	}
-	return tagFileResized;
+	fileClose ();
 }
 
-extern boolean parseFile (const char *const fileName)
+extern void parseFile (const char *const fileName)
 {
-	boolean tagFileResized = FALSE;
 	langType language = Option.language;
 	if (Option.language == LANG_AUTO)
 		language = getFileLanguage (fileName);
@@ -720,15 +977,13 @@ extern boolean parseFile (const char *const fileName)
 		if (Option.filter)
 			openTagFile ();
 
-		tagFileResized = createTagsWithFallback (fileName, language);
+		createTagsWithFallback (fileName, language);
+		commitTagBatch ();
 
 		if (Option.filter)
-			closeTagFile (tagFileResized);
+			closeTagFile ();
 		addTotals (1, 0L, 0L);
-
-		return tagFileResized;
 	}
-	return tagFileResized;
 }
 
 /* vi:set tabstop=4 shiftwidth=4 nowrap: */
@@ -113,7 +113,7 @@ extern boolean processKindOption (const char *const option, const char *const pa
 extern void printKindOptions (void);
 extern void printLanguageKinds (const langType language);
 extern void printLanguageList (void);
-extern boolean parseFile (const char *const fileName);
+extern void parseFile (const char *const fileName);
 
 /* Regex interface */
 #ifdef HAVE_REGEX
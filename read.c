@@ -17,6 +17,19 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>  /* to define LONG_MAX */
+
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+# define USE_MMAP
+#endif
+
+#ifdef USE_MMAP
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# include <sys/stat.h>  /* to declare fstat () */
+# include <sys/mman.h>  /* to declare mmap () */
+#endif
 
 #define FILE_WRITE
 #include "read.h"
@@ -31,6 +44,7 @@
 */
 inputFile File;  /* globally read through macros */
 static fpos_t StartOfLine;  /* holds deferred position of start of line */
+static boolean BufferIsMapped;  /* was File.buffer obtained from mmap ()? */
 
 /*
 *   FUNCTION DEFINITIONS
@@ -50,6 +64,161 @@ extern void freeSourceFileResources (void)
 		vStringDelete (File.line);
 }
 
+/*
+ *   Input position and character access
+ *
+ *   When the source file is held in memory, file positions are byte offsets
+ *   into the buffer, carried opaquely inside an fpos_t so that parsers and
+ *   tag entries need not know how the file is being read.
+ */
+
+static void getInputPosition (fpos_t *const pos)
+{
+	if (File.buffer != NULL)
+	{
+		const long offset = (long) File.bufferOffset;
+		memset (pos, 0, sizeof (fpos_t));
+		memcpy (pos, &offset, sizeof (offset));
+	}
+	else
+		fgetpos (File.fp, pos);
+}
+
+static long getPositionOffset (fpos_t *const pos)
+{
+	long offset;
+	memcpy (&offset, pos, sizeof (offset));
+	return offset;
+}
+
+static void setInputPosition (fpos_t *const pos)
+{
+	if (File.buffer != NULL)
+		File.bufferOffset = (size_t) getPositionOffset (pos);
+	else
+		fsetpos (File.fp, pos);
+}
+
+static int readChar (void)
+{
+	int c;
+	if (File.buffer == NULL)
+		c = getc (File.fp);
+	else if (File.bufferOffset < File.bufferSize)
+		c = File.buffer [File.bufferOffset++];
+	else
+		c = EOF;
+	return c;
+}
+
+static void unreadChar (const int c)
+{
+	if (File.buffer == NULL)
+		ungetc (c, File.fp);
+	else if (c != EOF)
+		--File.bufferOffset;
+}
+
+#ifdef USE_MMAP
+/*  Maps the whole of a regular source file into memory, so that it can be
+ *  read without going through stdio.
+ */
+static void mapInputFile (void)
+{
+	const int fd = fileno (File.fp);
+	struct stat status;
+
+	if (fstat (fd, &status) == 0  &&  S_ISREG (status.st_mode)  &&
+		status.st_size > 0  &&  status.st_size <= LONG_MAX)
+	{
+		void *const addr = mmap (NULL, (size_t) status.st_size,
+				PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED)
+		{
+			File.buffer = (const unsigned char *) addr;
+			File.bufferSize = (size_t) status.st_size;
+			BufferIsMapped = TRUE;
+		}
+	}
+}
+#endif
+
+/*  Reads the whole of a source file which could not be mapped into an
+ *  allocated buffer, so that its lines can be retrieved again when writing
+ *  tags without seeking in and re-reading the file.
+ */
+static void loadInputFile (void)
+{
+	enum { InitialSize = 64 * 1024 };
+	char *contents = NULL;
+	size_t allocated = 0;
+	size_t size = 0;
+	size_t count;
+
+	do
+	{
+		if (size == allocated)
+		{
+			allocated = (allocated == 0) ? InitialSize : 2 * allocated;
+			contents = xRealloc (contents, allocated, char);
+		}
+		count = fread (contents + size, (size_t) 1, allocated - size, File.fp);
+		size += count;
+	} while (count > 0);
+
+	if (ferror (File.fp)  ||  size == 0  ||  size > (size_t) LONG_MAX)
+	{
+		/*  Fall back to reading the file through File.fp.
+		 */
+		eFree (contents);
+		clearerr (File.fp);
+		rewind (File.fp);
+	}
+	else
+	{
+		File.buffer = (const unsigned char *) contents;
+		File.bufferSize = size;
+		BufferIsMapped = FALSE;
+	}
+}
+
+/*  Makes the contents of the newly opened source file available in
+ *  File.buffer, unless positions cannot be represented as offsets on this
+ *  host. Empty files are read through File.fp.
+ */
+static void bufferInputFile (void)
+{
+	File.buffer = NULL;
+	File.bufferSize = 0;
+	File.bufferOffset = 0;
+	if (sizeof (fpos_t) >= sizeof (long))
+	{
+#ifdef USE_MMAP
+		mapInputFile ();
+#endif
+#ifndef macintosh  /* buffered lines are not split at lone carriage returns */
+		if (File.buffer == NULL)
+			loadInputFile ();
+#endif
+	}
+}
+
+static void releaseInputBuffer (void)
+{
+	if (File.buffer != NULL)
+	{
+#ifdef USE_MMAP
+		if (BufferIsMapped)
+			munmap ((void *) File.buffer, File.bufferSize);
+		else
+#endif
+			eFree ((void *) File.buffer);
+	}
+	File.buffer = NULL;
+	File.bufferSize = 0;
+	File.bufferOffset = 0;
+}
+
 /*
  *   Source file access functions
  */
@@ -75,6 +244,17 @@ static void setInputFileName (const char *const fileName)
 	}
 }
 
+/*  Returns the name by which the source file "fileName" is referred to in the
+ *  tag file. The caller must free the result.
+ */
+extern char *makeSourceFileTagPath (const char *const fileName)
+{
+	if (! Option.tagRelative || isAbsolutePath (fileName))
+		return eStrdup (fileName);
+	else
+		return relativeFilename (fileName, TagFile.directory);
+}
+
 static void setSourceFileParameters (vString *const fileName)
 {
 	if (File.source.name != NULL)
@@ -83,11 +263,7 @@ static void setSourceFileParameters (vString *const fileName)
 
 	if (File.source.tagPath != NULL)
 		eFree (File.source.tagPath);
-	if (! Option.tagRelative || isAbsolutePath (vStringValue (fileName)))
-		File.source.tagPath = eStrdup (vStringValue (fileName));
-	else
-		File.source.tagPath =
-				relativeFilename (vStringValue (fileName), TagFile.directory);
+	File.source.tagPath = makeSourceFileTagPath (vStringValue (fileName));
 
 	if (vStringLength (fileName) > TagFile.max.file)
 		TagFile.max.file = vStringLength (fileName);
@@ -121,7 +297,7 @@ static int skipWhite (void)
 {
 	int c;
 	do
-		c = getc (File.fp);
+		c = readChar ();
 	while (c == ' '  ||  c == '\t');
 	return c;
 }
@@ -133,9 +309,9 @@ static unsigned long readLineNumber (void)
 	while (c != EOF  &&  isdigit (c))
 	{
 		lNum = (lNum * 10) + (c - '0');
-		c = getc (File.fp);
+		c = readChar ();
 	}
-	ungetc (c, File.fp);
+	unreadChar (c);
 	if (c != ' '  &&  c != '\t')
 		lNum = 0;
 
@@ -158,17 +334,17 @@ static vString *readFileName (void)
 
 	if (c == '"')
 	{
-		c = getc (File.fp);  /* skip double-quote */
+		c = readChar ();  /* skip double-quote */
 		quoteDelimited = TRUE;
 	}
 	while (c != EOF  &&  c != '\n'  &&
 			(quoteDelimited ? (c != '"') : (c != ' '  &&  c != '\t')))
 	{
 		vStringPut (fileName, c);
-		c = getc (File.fp);
+		c = readChar ();
 	}
 	if (c == '\n')
-		ungetc (c, File.fp);
+		unreadChar (c);
 	vStringPut (fileName, '\0');
 
 	return fileName;
@@ -182,13 +358,13 @@ static boolean parseLineDirective (void)
 
 	if (isdigit (c))
 	{
-		ungetc (c, File.fp);
+		unreadChar (c);
 		result = TRUE;
 	}
-	else if (c == 'l'  &&  getc (File.fp) == 'i'  &&
-			 getc (File.fp) == 'n'  &&  getc (File.fp) == 'e')
+	else if (c == 'l'  &&  readChar () == 'i'  &&
+			 readChar () == 'n'  &&  readChar () == 'e')
 	{
-		c = getc (File.fp);
+		c = readChar ();
 		if (c == ' '  ||  c == '\t')
 		{
 			DebugStatement ( lineStr = "line"; )
@@ -240,6 +416,25 @@ static boolean parseLineDirective (void)
  *   Source file I/O operations
  */
 
+/*  Sets up reading the open source file from its beginning.
+ */
+static void startInputFile (void)
+{
+	getInputPosition (&StartOfLine);
+	getInputPosition (&File.filePosition);
+	File.currentLine  = NULL;
+	File.lineNumber   = 0L;
+	File.ungetch      = '\0';
+	File.eof          = FALSE;
+	File.newLine      = TRUE;
+
+	if (File.line != NULL)
+		vStringClear (File.line);
+
+	setSourceFileParameters (vStringNewCopy (File.name));
+	File.source.lineNumber = 0L;
+}
+
 /*  This function opens a source file, and resets the line counter.  If it
  *  fails, it will display an error message and leave the File.fp set to NULL.
  */
@@ -256,6 +451,7 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 	 */
 	if (File.fp != NULL)
 	{
+		releaseInputBuffer ();
 		fclose (File.fp);  /* close any open source file */
 		File.fp = NULL;
 	}
@@ -268,18 +464,8 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 		opened = TRUE;
 
 		setInputFileName (fileName);
-		fgetpos (File.fp, &StartOfLine);
-		fgetpos (File.fp, &File.filePosition);
-		File.currentLine  = NULL;
-		File.lineNumber   = 0L;
-		File.eof          = FALSE;
-		File.newLine      = TRUE;
-
-		if (File.line != NULL)
-			vStringClear (File.line);
-
-		setSourceFileParameters (vStringNewInit (fileName));
-		File.source.lineNumber = 0L;
+		bufferInputFile ();
+		startInputFile ();
 
 		verbose ("OPENING %s as %s language %sfile\n", fileName,
 				getLanguageName (language),
@@ -300,11 +486,24 @@ extern void fileClose (void)
 			fileStatus *status = eStat (vStringValue (File.name));
 			addTotals (0, File.lineNumber - 1L, status->size);
 		}
+		releaseInputBuffer ();
 		fclose (File.fp);
 		File.fp = NULL;
 	}
 }
 
+/*  Restarts reading the open source file from its beginning, for a parser
+ *  to go over it again without opening and loading it anew.
+ */
+extern void fileRewind (void)
+{
+	if (File.buffer != NULL)
+		File.bufferOffset = 0;
+	else
+		rewind (File.fp);
+	startInputFile ();
+}
+
 extern boolean fileEOF (void)
 {
 	return File.eof;
@@ -329,7 +528,7 @@ static int iFileGetc (void)
 {
 	int	c;
 readnext:
-	c = getc (File.fp);
+	c = readChar ();
 
 	/*	If previous character was a newline, then we're starting a line.
 	 */
@@ -342,8 +541,8 @@ readnext:
 				goto readnext;
 			else
 			{
-				fsetpos (File.fp, &StartOfLine);
-				c = getc (File.fp);
+				setInputPosition (&StartOfLine);
+				c = readChar ();
 			}
 		}
 	}
@@ -353,7 +552,7 @@ readnext:
 	else if (c == NEWLINE)
 	{
 		File.newLine = TRUE;
-		fgetpos (File.fp, &StartOfLine);
+		getInputPosition (&StartOfLine);
 	}
 	else if (c == CRETURN)
 	{
@@ -362,15 +561,15 @@ readnext:
 		 * and CR-LF (MS-DOS) are converted into a generic newline.
 		 */
 #ifndef macintosh
-		const int next = getc (File.fp);  /* is CR followed by LF? */
+		const int next = readChar ();  /* is CR followed by LF? */
 		if (next != NEWLINE)
-			ungetc (next, File.fp);
+			unreadChar (next);
 		else
 #endif
 		{
 			c = NEWLINE;  /* convert CR into newline */
 			File.newLine = TRUE;
-			fgetpos (File.fp, &StartOfLine);
+			getInputPosition (&StartOfLine);
 		}
 	}
 	DebugStatement ( debugPutc (DEBUG_RAW, c); )
@@ -382,6 +581,59 @@ extern void fileUngetc (int c)
 	File.ungetch = c;
 }
 
+/*  Reads the next line of the buffered source file into File.line in a single
+ *  copy, performing the same newline canonicalization as iFileGetc ().
+ */
+static void iBufferGetLine (void)
+{
+	const char *const start = (const char *) File.buffer + File.bufferOffset;
+	const size_t remaining = File.bufferSize - File.bufferOffset;
+	const char *const newline = memchr (start, NEWLINE, remaining);
+	size_t length = (newline == NULL) ? remaining : (size_t) (newline - start);
+
+	if (remaining == 0)
+	{
+		File.eof = TRUE;
+		return;
+	}
+	if (File.newLine)
+		fileNewline ();
+	File.bufferOffset += length;
+	if (newline == NULL)
+		File.eof = TRUE;
+	else
+	{
+		++File.bufferOffset;
+		if (length > 0  &&  start [length - 1] == CRETURN)
+			--length;
+	}
+
+	/*  Null characters are dropped from lines, as vStringPut () does.
+	 */
+	if (memchr (start, '\0', length) == NULL)
+		vStringNCatSUnsafe (File.line, start, length);
+	else
+	{
+		size_t i;
+		for (i = 0  ;  i < length  ;  ++i)
+			vStringPut (File.line, start [i]);
+	}
+	if (newline != NULL)
+	{
+		vStringPut (File.line, NEWLINE);
+		File.newLine = TRUE;
+		getInputPosition (&StartOfLine);
+	}
+	DebugStatement ( debugPrintf (DEBUG_RAW, "%s", vStringValue (File.line)); )
+}
+
+static boolean isLineDirectiveNext (void)
+{
+	return (boolean) (Option.lineDirectives  &&  File.newLine  &&
+			File.bufferOffset < File.bufferSize  &&
+			File.buffer [File.bufferOffset] == '#');
+}
+
 static vString *iFileGetLine (void)
 {
 	vString *result = NULL;
@@ -389,22 +641,23 @@ static vString *iFileGetLine (void)
 	if (File.line == NULL)
 		File.line = vStringNew ();
 	vStringClear (File.line);
-	do
+	if (File.buffer != NULL  &&  ! isLineDirectiveNext ())
+		iBufferGetLine ();
+	else do
 	{
 		c = iFileGetc ();
 		if (c != EOF)
 			vStringPut (File.line, c);
-		if (c == '\n'  ||  (c == EOF  &&  vStringLength (File.line) > 0))
-		{
-			vStringTerminate (File.line);
+	} while (c != '\n'  &&  c != EOF);
+
+	if (vStringLength (File.line) > 0)
+	{
+		vStringTerminate (File.line);
 #ifdef HAVE_REGEX
-			if (vStringLength (File.line) > 0)
-				matchRegex (File.line, File.source.language);
+		matchRegex (File.line, File.source.language);
 #endif
-			result = File.line;
-			break;
-		}
-	} while (c != EOF);
+		result = File.line;
+	}
 	Assert (result != NULL  ||  File.eof);
 	return result;
 }
@@ -479,6 +732,26 @@ extern const unsigned char *fileReadLine (void)
 /*
  *   Source file line reading with automatic buffer sizing
  */
+
+/*  Converts a line ending in CR or CR-LF into one ending in a single newline.
+ */
+static void canonicalizeNewline (vString *const vLine)
+{
+	const size_t length = vStringLength (vLine);
+	if (length > 0)
+	{
+		char *const eol = vStringValue (vLine) + length - 1;
+		if (*eol == '\r')
+			*eol = '\n';
+		else if (length > 1  &&  *(eol - 1) == '\r'  &&  *eol == '\n')
+		{
+			*(eol - 1) = '\n';
+			*eol = '\0';
+			--vLine->length;
+		}
+	}
+}
+
 extern char *readLine (vString *const vLine, FILE *const fp)
 {
 	char *result = NULL;
@@ -521,41 +794,68 @@ extern char *readLine (vString *const vLine, FILE *const fp)
 			}
 			else
 			{
-				char* eol;
 				vStringSetLength (vLine);
-				/* canonicalize new line */
-				eol = vStringValue (vLine) + vStringLength (vLine) - 1;
-				if (*eol == '\r')
-					*eol = '\n';
-				else if (*(eol - 1) == '\r'  &&  *eol == '\n')
-				{
-					*(eol - 1) = '\n';
-					*eol = '\0';
-					--vLine->length;
-				}
+				canonicalizeNewline (vLine);
 			}
 		} while (reReadLine);
 	}
 	return result;
 }
 
+/*  Places into the line buffer the line of the buffered source file starting
+ *  at "offset", exactly as readLine () would have read it.
+ */
+static char *readBufferLine (vString *const vLine, const size_t offset)
+{
+	char *result = NULL;
+
+	vStringClear (vLine);
+	if (offset < File.bufferSize)
+	{
+		const char *const start = (const char *) File.buffer + offset;
+		const size_t remaining = File.bufferSize - offset;
+		const char *const newline = memchr (start, NEWLINE, remaining);
+		size_t length = (newline == NULL) ? remaining :
+				(size_t) (newline - start) + 1;
+		const char *const nul = memchr (start, '\0', length);
+
+		if (nul != NULL)
+			length = (size_t) (nul - start);
+		vStringNCatSUnsafe (vLine, start, length);
+		canonicalizeNewline (vLine);
+		result = vStringValue (vLine);
+	}
+	return result;
+}
+
 /*  Places into the line buffer the contents of the line referenced by
  *  "location".
  */
 extern char *readSourceLine (
 		vString *const vLine, fpos_t location, long *const pSeekValue)
 {
-	fpos_t orignalPosition;
 	char *result;
 
-	fgetpos (File.fp, &orignalPosition);
-	fsetpos (File.fp, &location);
-	if (pSeekValue != NULL)
-		*pSeekValue = ftell (File.fp);
-	result = readLine (vLine, File.fp);
+	if (File.buffer != NULL)
+	{
+		const long offset = getPositionOffset (&location);
+		if (pSeekValue != NULL)
+			*pSeekValue = offset;
+		result = readBufferLine (vLine, (size_t) offset);
+	}
+	else
+	{
+		fpos_t orignalPosition;
+
+		fgetpos (File.fp, &orignalPosition);
+		fsetpos (File.fp, &location);
+		if (pSeekValue != NULL)
+			*pSeekValue = ftell (File.fp);
+		result = readLine (vLine, File.fp);
+		fsetpos (File.fp, &orignalPosition);
+	}
 	if (result == NULL)
 		error (FATAL, "Unexpected end of file: %s", vStringValue (File.name));
-	fsetpos (File.fp, &orignalPosition);
 
 	return result;
 }
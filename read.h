@@ -74,6 +74,9 @@ typedef struct sInputFile {
 	vString    *line;          /* last line read from file */
 	const unsigned char* currentLine;  /* current line being worked on */
 	FILE       *fp;            /* stream used for reading the file */
+	const unsigned char *buffer;  /* contents of file, if held in memory */
+	size_t      bufferSize;    /* size of buffered file contents */
+	size_t      bufferOffset;  /* offset of next character in buffer */
 	unsigned long lineNumber;  /* line number in the input file */
 	fpos_t      filePosition;  /* file position of current line */
 	int         ungetch;       /* a single character that was ungotten */
@@ -102,9 +105,11 @@ extern CONST_FILE inputFile File;
 *   FUNCTION PROTOTYPES
 */
 extern void freeSourceFileResources (void);
+extern char *makeSourceFileTagPath (const char *const fileName);
 extern boolean fileOpen (const char *const fileName, const langType language);
 extern boolean fileEOF (void);
 extern void fileClose (void);
+extern void fileRewind (void);
 extern int fileGetc (void);
 extern int fileSkipToCharacter (int c);
 extern void fileUngetc (int c);
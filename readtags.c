@@ -17,6 +17,15 @@
 #include <stdio.h>
 #include <errno.h>
 #include <sys/types.h>  /* to declare off_t */
+#include <sys/stat.h>   /* to declare stat() */
+#include <time.h>
+#if !defined (READTAGS_NO_MMAP) && (defined (__unix__) || defined (__APPLE__))
+# include <unistd.h>    /* to define _POSIX_MAPPED_FILES */
+# if defined (_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#  include <sys/mman.h>
+#  define USE_MMAP
+# endif
+#endif
 
 #include "readtags.h"
 
@@ -24,6 +33,11 @@
 *   MACROS
 */
 #define TAB '\t'
+#define INDEX_SUFFIX ".idx"
+#define INDEX_HEADER "!_TAGS_INDEX\t2"
+#define INDEX_ENTRY_SIZE 8
+#define HASH_INITIAL 2166136261UL  /* FNV-1a, truncated to 32 bits */
+#define HASH_PRIME 16777619UL
 
 
 /*
@@ -44,6 +58,15 @@ struct sTagFile {
 	sortType sortMethod;
 		/* pointer to file structure */
 	FILE* fp;
+		/* contents of tag file, if mapped into memory (see tagsOpenMapped) */
+	const char *map;
+		/* position in `map' of the next line to read */
+	off_t mapPos;
+		/* length of last line found in `map', and of the tag name it starts with */
+	size_t mapLineLength;
+	size_t mapNameLength;
+		/* has last line found in `map' been copied into `line' and `name'? */
+	short mapLineLoaded;
 		/* file position of first character of `line' */
 	off_t pos;
 		/* size of tag file in seekable positions */
@@ -72,6 +95,23 @@ struct sTagFile {
 				/* list of key value pairs */
 			tagExtensionField *list;
 	} fields;
+		/* companion index of the tag file */
+	struct {
+				/* pointer to index file (NULL if there is none) */
+			FILE *fp;
+				/* contents of index file, if mapped into memory */
+			const unsigned char *map;
+				/* size of index file */
+			off_t size;
+				/* number of tags in each ordering of the index */
+			off_t count;
+				/* file position of the first entry of the index */
+			off_t base;
+				/* which ordering is searched (0 = exact, 1 = folded case) */
+			short folded;
+				/* position in index of last match (-1 if not searching) */
+			off_t current;
+	} index;
 		/* buffers to be freed at close */
 	struct {
 			/* name of program author */
@@ -170,11 +210,79 @@ static void copyName (tagFile *const file)
 	file->name.buffer [length] = '\0';
 }
 
+static int seekTagFile (tagFile *const file, const off_t pos)
+{
+	int result;
+	if (file->map == NULL)
+		result = (fseek (file->fp, pos, SEEK_SET) == 0);
+	else
+	{
+		file->mapPos = (pos < file->size) ? pos : file->size;
+		result = 1;
+	}
+	return result;
+}
+
+static off_t tellTagFile (tagFile *const file)
+{
+	return (file->map == NULL) ? (off_t) ftell (file->fp) : file->mapPos;
+}
+
+/* Finds the extent of the next line of a mapped tag file without copying it */
+static int readMappedLine (tagFile *const file)
+{
+	int result = 0;
+	if (file->mapPos < file->size)
+	{
+		const char *const start = file->map + file->mapPos;
+		const size_t remaining = (size_t) (file->size - file->mapPos);
+		const char *const newline = (const char*) memchr (start, '\n', remaining);
+		size_t length = (newline == NULL) ? remaining : (size_t) (newline - start);
+		const char *nul, *tab;
+
+		file->pos = file->mapPos;
+		file->mapPos += length + (newline != NULL);
+		nul = (const char*) memchr (start, '\0', length);
+		if (nul != NULL)
+			length = nul - start;
+		while (length > 0  &&  start [length - 1] == '\r')
+			--length;
+		tab = (const char*) memchr (start, TAB, length);
+		file->mapLineLength = length;
+		file->mapNameLength = (tab == NULL) ? length : (size_t) (tab - start);
+		file->mapLineLoaded = 0;
+		result = 1;
+	}
+	return result;
+}
+
+/* Copies the last line found in a mapped tag file into `line' and `name' */
+static int loadLine (tagFile *const file)
+{
+	int result = 1;
+	if (file->map != NULL  &&  ! file->mapLineLoaded)
+	{
+		while (result  &&  file->mapLineLength >= file->line.size)
+			result = growString (&file->line);
+		if (result)
+		{
+			memcpy (file->line.buffer, file->map + file->pos, file->mapLineLength);
+			file->line.buffer [file->mapLineLength] = '\0';
+			copyName (file);
+			file->mapLineLoaded = 1;
+		}
+	}
+	return result;
+}
+
 static int readTagLineRaw (tagFile *const file)
 {
 	int result = 1;
 	int reReadLine;
 
+	if (file->map != NULL)
+		return readMappedLine (file);
+
 	/*  If reading the line places any character other than a null or a
 	 *  newline at the last character position in the buffer (one less than
 	 *  the buffer size), then we must resize the buffer and reattempt to read
@@ -226,7 +334,8 @@ static int readTagLine (tagFile *const file)
 	do
 	{
 		result = readTagLineRaw (file);
-	} while (result && *file->name.buffer == '\0');
+	} while (result  &&  (file->map != NULL ?
+			file->mapNameLength == 0 : *file->name.buffer == '\0'));
 	return result;
 }
 
@@ -292,8 +401,12 @@ static void parseExtensionFields (tagFile *const file, tagEntry *const entry,
 static void parseTagLine (tagFile *file, tagEntry *const entry)
 {
 	int i;
-	char *p = file->line.buffer;
-	char *tab = strchr (p, TAB);
+	char *p;
+	char *tab;
+
+	loadLine (file);
+	p = file->line.buffer;
+	tab = strchr (p, TAB);
 
 	entry->fields.list = NULL;
 	entry->fields.count = 0;
@@ -370,7 +483,7 @@ static char *duplicate (const char *str)
 
 static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
 	if (info != NULL)
 	{
@@ -383,8 +496,8 @@ static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 	}
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		startOfLine = tellTagFile (file);
+		if (! readTagLine (file)  ||  ! loadLine (file))
 			break;
 		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
 			break;
@@ -418,26 +531,176 @@ static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 			}
 		}
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
 }
 
 static void gotoFirstLogicalTag (tagFile *const file)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
-	rewind (file->fp);
+	seekTagFile (file, 0);
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		startOfLine = tellTagFile (file);
+		if (! readTagLine (file)  ||  ! loadLine (file))
 			break;
 		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
 			break;
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
+}
+
+/*
+*  Tag file index support. The index of a tag file lives next to it, with the
+*  INDEX_SUFFIX appended to its name. It starts with a text header holding the
+*  size, modification time and inode of the tag file it was built from, the
+*  time the index was started, a checksum of the tag lines and the number of
+*  tags it orders, followed by the file positions of the tag lines ordered by
+*  name, first exactly, then with case folded, each written as
+*  INDEX_ENTRY_SIZE bytes with the most significant first.
+*
+*  Modification times only have a resolution of one second, so a tag file
+*  rewritten within the second its index was started can keep its size and
+*  time stamp. Such an index is only used once the checksum of the tag file
+*  is found to match.
+*/
+
+/* Adds the position and contents of the last line loaded to a checksum */
+static unsigned long hashTagLine (const tagFile *const file, unsigned long hash)
+{
+	const unsigned char *p = (const unsigned char*) file->line.buffer;
+	off_t pos = file->pos;
+	int i;
+	for (i = 0  ;  i < INDEX_ENTRY_SIZE  ;  ++i)
+	{
+		hash = ((hash ^ (unsigned long) (pos & 0xff)) * HASH_PRIME) & 0xffffffffUL;
+		pos >>= 8;
+	}
+	while (*p != '\0')
+		hash = ((hash ^ *p++) * HASH_PRIME) & 0xffffffffUL;
+	return hash;
+}
+
+/* Returns the checksum of the tag lines of the file, leaving it positioned
+ * where it was */
+static unsigned long checksumTagFile (tagFile *const file)
+{
+	const off_t pos = tellTagFile (file);
+	unsigned long hash = HASH_INITIAL;
+	seekTagFile (file, 0);
+	while (readTagLine (file)  &&  loadLine (file))
+		hash = hashTagLine (file, hash);
+	seekTagFile (file, pos);
+	return hash;
+}
+
+static char *indexFileName (const char *const filePath)
+{
+	char *result = (char*) malloc (strlen (filePath) + strlen (INDEX_SUFFIX) + 1);
+	if (result == NULL)
+		perror (NULL);
+	else
+	{
+		strcpy (result, filePath);
+		strcat (result, INDEX_SUFFIX);
+	}
+	return result;
+}
+
+static void writeIndexEntry (FILE *const fp, off_t value)
+{
+	unsigned char bytes [INDEX_ENTRY_SIZE];
+	int i;
+	for (i = INDEX_ENTRY_SIZE - 1  ;  i >= 0  ;  --i)
+	{
+		bytes [i] = (unsigned char) (value & 0xff);
+		value >>= 8;
+	}
+	fwrite (bytes, (size_t) 1, (size_t) INDEX_ENTRY_SIZE, fp);
+}
+
+static int readIndexEntry (tagFile *const file, const off_t i, off_t *const pos)
+{
+	int result = 0;
+	const off_t entry = (file->index.folded ? file->index.count : 0) + i;
+	const off_t offset = file->index.base + entry * INDEX_ENTRY_SIZE;
+	unsigned char buffer [INDEX_ENTRY_SIZE];
+	const unsigned char *bytes = NULL;
+	if (file->index.map != NULL)
+		bytes = file->index.map + offset;
+	else if (fseek (file->index.fp, offset, SEEK_SET) == 0  &&
+		fread (buffer, (size_t) 1, (size_t) INDEX_ENTRY_SIZE,
+				file->index.fp) == INDEX_ENTRY_SIZE)
+		bytes = buffer;
+	if (bytes != NULL)
+	{
+		off_t value = 0;
+		int j;
+		for (j = 0  ;  j < INDEX_ENTRY_SIZE  ;  ++j)
+			value = (value << 8) | bytes [j];
+		*pos = value;
+		result = 1;
+	}
+	return result;
+}
+
+/* Opens the index of the tag file, if there is one and it is up to date */
+static void openIndex (tagFile *const file, const char *const filePath)
+{
+	struct stat status;
+	char *const indexName = indexFileName (filePath);
+	file->index.fp = NULL;
+	file->index.map = NULL;
+	file->index.current = -1;
+	if (indexName != NULL  &&  stat (filePath, &status) == 0)
+	{
+		FILE *const fp = fopen (indexName, "rb");
+		if (fp != NULL)
+		{
+			char header [160];
+			unsigned long size, mtime, inode, started, checksum, count;
+			int valid = 0;
+			if (fgets (header, (int) sizeof (header), fp) != NULL  &&
+				strncmp (header, INDEX_HEADER, strlen (INDEX_HEADER)) == 0  &&
+				sscanf (header + strlen (INDEX_HEADER),
+						"\t%lu\t%lu\t%lu\t%lu\t%lx\t%lu", &size, &mtime,
+						&inode, &started, &checksum, &count) == 6  &&
+				size == (unsigned long) file->size  &&
+				mtime == (unsigned long) status.st_mtime  &&
+				inode == (unsigned long) status.st_ino  &&
+				(mtime < started  ||  checksum == checksumTagFile (file)))
+			{
+				const off_t base = ftell (fp);
+				fseek (fp, 0, SEEK_END);
+				file->index.size = ftell (fp);
+				valid = (file->index.size ==
+						base + (off_t) (2 * count * INDEX_ENTRY_SIZE));
+				file->index.base = base;
+				file->index.count = (off_t) count;
+			}
+			if (valid)
+			{
+				file->index.fp = fp;
+#ifdef USE_MMAP
+				if (file->map != NULL)
+				{
+					void *const map = mmap (NULL, (size_t) file->index.size,
+							PROT_READ, MAP_SHARED, fileno (fp), 0);
+					if (map != MAP_FAILED)
+						file->index.map = (const unsigned char*) map;
+				}
+#endif
+			}
+			else
+				fclose (fp);
+		}
+	}
+	if (indexName != NULL)
+		free (indexName);
 }
 
-static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
+static tagFile *initialize (const char *const filePath, tagFileInfo *const info,
+							const int mapped)
 {
 	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
 	if (result != NULL)
@@ -459,7 +722,17 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 			fseek (result->fp, 0, SEEK_END);
 			result->size = ftell (result->fp);
 			rewind (result->fp);
+#ifdef USE_MMAP
+			if (mapped  &&  result->size > 0)
+			{
+				void *const map = mmap (NULL, (size_t) result->size,
+						PROT_READ, MAP_SHARED, fileno (result->fp), 0);
+				if (map != MAP_FAILED)
+					result->map = (const char*) map;
+			}
+#endif
 			readPseudoTags (result, info);
+			openIndex (result, filePath);
 			info->status.opened = 1;
 			result->initialized = 1;
 		}
@@ -469,7 +742,15 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 
 static void terminate (tagFile *const file)
 {
+#ifdef USE_MMAP
+	if (file->map != NULL)
+		munmap ((void*) file->map, (size_t) file->size);
+	if (file->index.map != NULL)
+		munmap ((void*) file->index.map, (size_t) file->index.size);
+#endif
 	fclose (file->fp);
+	if (file->index.fp != NULL)
+		fclose (file->index.fp);
 
 	free (file->line.buffer);
 	free (file->name.buffer);
@@ -525,7 +806,7 @@ static const char *readFieldValue (
 static int readTagLineSeek (tagFile *const file, const off_t pos)
 {
 	int result = 0;
-	if (fseek (file->fp, pos, SEEK_SET) == 0)
+	if (seekTagFile (file, pos))
 	{
 		result = readTagLine (file);  /* read probable partial line */
 		if (pos > 0  &&  result)
@@ -534,10 +815,38 @@ static int readTagLineSeek (tagFile *const file, const off_t pos)
 	return result;
 }
 
+/* Compares `name' with the tag name of `length' characters at `tag' the same
+ * way as the comparisons of nameComparison(), over at most `n' characters.
+ */
+static int compareMappedName (const char *name, const char *tag,
+							  const size_t length, const size_t n,
+							  const int ignorecase)
+{
+	int result = 0;
+	size_t i;
+	for (i = 0  ;  i < n  ;  ++i)
+	{
+		const char c1 = name [i];
+		const char c2 = (i < length) ? tag [i] : '\0';
+		if (ignorecase)
+			result = toupper ((int) c1) - toupper ((int) c2);
+		else
+			result = (int) (unsigned char) c1 - (int) (unsigned char) c2;
+		if (result != 0  ||  c1 == '\0'  ||  c2 == '\0')
+			break;
+	}
+	return result;
+}
+
 static int nameComparison (tagFile *const file)
 {
 	int result;
-	if (file->search.ignorecase)
+	if (file->map != NULL)
+		result = compareMappedName (file->search.name, file->map + file->pos,
+				file->mapNameLength, file->search.partial ?
+					file->search.nameLength : (size_t) -1,
+				file->search.ignorecase);
+	else if (file->search.ignorecase)
 	{
 		if (file->search.partial)
 			result = strnuppercmp (file->search.name, file->name.buffer,
@@ -632,6 +941,52 @@ static tagResult findBinary (tagFile *const file)
 	return result;
 }
 
+static int readIndexedTagLine (tagFile *const file, const off_t i)
+{
+	off_t pos;
+	return readIndexEntry (file, i, &pos)  &&
+		seekTagFile (file, pos)  &&  readTagLine (file);
+}
+
+/* Finds the first match in the ordering of the index selected by the search */
+static tagResult findIndexed (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	off_t lower = 0;
+	off_t upper = file->index.count;
+	file->index.folded = file->search.ignorecase;
+	while (lower < upper)
+	{
+		const off_t middle = lower + (upper - lower) / 2;
+		if (! readIndexedTagLine (file, middle))
+			return TagFailure;
+		if (nameComparison (file) > 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower < file->index.count  &&  readIndexedTagLine (file, lower)  &&
+		nameComparison (file) == 0)
+	{
+		file->index.current = lower;
+		result = TagSuccess;
+	}
+	return result;
+}
+
+static tagResult findNextIndexed (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	const off_t next = file->index.current + 1;
+	if (next < file->index.count  &&  readIndexedTagLine (file, next)  &&
+		nameComparison (file) == 0)
+	{
+		file->index.current = next;
+		result = TagSuccess;
+	}
+	return result;
+}
+
 static tagResult findSequential (tagFile *const file)
 {
 	tagResult result = TagFailure;
@@ -656,15 +1011,28 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 	file->search.nameLength = strlen (name);
 	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
 	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	fseek (file->fp, 0, SEEK_END);
-	file->size = ftell (file->fp);
-	rewind (file->fp);
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
+	file->index.current = -1;
+	if (file->index.fp != NULL)
+	{
+#ifdef DEBUG
+		printf ("<performing indexed search>\n");
+#endif
+		result = findIndexed (file);
+		if (result != TagSuccess)
+			file->index.current = file->index.count;
+	}
+	else if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
 	{
 #ifdef DEBUG
 		printf ("<performing binary search>\n");
 #endif
+		if (file->map == NULL)
+		{
+			fseek (file->fp, 0, SEEK_END);
+			file->size = ftell (file->fp);
+		}
+		seekTagFile (file, 0);
 		result = findBinary (file);
 	}
 	else
@@ -672,6 +1040,7 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 #ifdef DEBUG
 		printf ("<performing sequential search>\n");
 #endif
+		seekTagFile (file, 0);
 		result = findSequential (file);
 	}
 
@@ -689,7 +1058,13 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 static tagResult findNext (tagFile *const file, tagEntry *const entry)
 {
 	tagResult result;
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
+	if (file->index.current >= 0)
+	{
+		result = findNextIndexed (file);
+		if (result == TagSuccess  &&  entry != NULL)
+			parseTagLine (file, entry);
+	}
+	else if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
 	{
 		result = tagsNext (file, entry);
@@ -705,13 +1080,133 @@ static tagResult findNext (tagFile *const file, tagEntry *const entry)
 	return result;
 }
 
+/* Tag names and positions collected while building an index */
+typedef struct {
+	off_t pos;
+	size_t name;  /* offset of name in IndexNames */
+} indexEntry;
+
+static const char *IndexNames;
+
+static int compareIndexEntries (const void *const one, const void *const two)
+{
+	const indexEntry *const e1 = (const indexEntry*) one;
+	const indexEntry *const e2 = (const indexEntry*) two;
+	int result = strcmp (IndexNames + e1->name, IndexNames + e2->name);
+	if (result == 0)
+		result = (e1->pos < e2->pos) ? -1 : (e1->pos > e2->pos);
+	return result;
+}
+
+static int compareIndexEntriesFolded (const void *const one, const void *const two)
+{
+	const indexEntry *const e1 = (const indexEntry*) one;
+	const indexEntry *const e2 = (const indexEntry*) two;
+	int result = struppercmp (IndexNames + e1->name, IndexNames + e2->name);
+	if (result == 0)
+		result = (e1->pos < e2->pos) ? -1 : (e1->pos > e2->pos);
+	return result;
+}
+
+static tagResult createIndex (tagFile *const file, const char *const filePath)
+{
+	tagResult result = TagFailure;
+	struct stat status;
+	char *names = NULL;
+	size_t namesLength = 0, namesSize = 0;
+	indexEntry *entries = NULL;
+	size_t count = 0, max = 0;
+	char *const indexName = indexFileName (filePath);
+	const unsigned long started = (unsigned long) time (NULL);
+	unsigned long checksum = HASH_INITIAL;
+	int ok = (indexName != NULL  &&  stat (filePath, &status) == 0);
+
+	seekTagFile (file, 0);
+	while (ok  &&  readTagLine (file)  &&  loadLine (file))
+	{
+		const size_t length = strlen (file->name.buffer) + 1;
+		checksum = hashTagLine (file, checksum);
+		if (count == max)
+		{
+			indexEntry *const newEntries = (indexEntry*) realloc (entries,
+					(max = (max == 0) ? 1024 : 2 * max) * sizeof (indexEntry));
+			if (newEntries == NULL)
+				ok = 0;
+			else
+				entries = newEntries;
+		}
+		while (ok  &&  namesLength + length > namesSize)
+		{
+			char *const newNames = (char*) realloc (names,
+					namesSize = (namesSize == 0) ? 65536 : 2 * namesSize);
+			if (newNames == NULL)
+				ok = 0;
+			else
+				names = newNames;
+		}
+		if (ok)
+		{
+			memcpy (names + namesLength, file->name.buffer, length);
+			entries [count].pos = file->pos;
+			entries [count].name = namesLength;
+			namesLength += length;
+			++count;
+		}
+	}
+	if (! ok)
+		perror ("cannot create tag file index");
+	else
+	{
+		FILE *const fp = fopen (indexName, "wb");
+		if (fp == NULL)
+			perror (indexName);
+		else
+		{
+			size_t i;
+			IndexNames = names;
+			fprintf (fp, "%s\t%lu\t%lu\t%lu\t%lu\t%lx\t%lu\n", INDEX_HEADER,
+					(unsigned long) file->size,
+					(unsigned long) status.st_mtime,
+					(unsigned long) status.st_ino, started, checksum,
+					(unsigned long) count);
+			if (count > 0)
+				qsort (entries, count, sizeof (indexEntry), compareIndexEntries);
+			for (i = 0  ;  i < count  ;  ++i)
+				writeIndexEntry (fp, entries [i].pos);
+			if (count > 0)
+				qsort (entries, count, sizeof (indexEntry),
+						compareIndexEntriesFolded);
+			for (i = 0  ;  i < count  ;  ++i)
+				writeIndexEntry (fp, entries [i].pos);
+			if (ferror (fp))
+				perror (indexName);
+			else
+				result = TagSuccess;
+			if (fclose (fp) != 0)
+				result = TagFailure;
+		}
+	}
+	if (names != NULL)
+		free (names);
+	if (entries != NULL)
+		free (entries);
+	if (indexName != NULL)
+		free (indexName);
+	return result;
+}
+
 /*
 *  EXTERNAL INTERFACE
 */
 
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info)
 {
-	return initialize (filePath, info);
+	return initialize (filePath, info, 0);
+}
+
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info)
+{
+	return initialize (filePath, info, 1);
 }
 
 extern tagResult tagsSetSortType (tagFile *const file, const sortType type)
@@ -769,6 +1264,19 @@ extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
 	return result;
 }
 
+extern tagResult tagsCreateIndex (const char *const filePath)
+{
+	tagResult result = TagFailure;
+	tagFileInfo info;
+	tagFile *const file = initialize (filePath, &info, 1);
+	if (file != NULL)
+	{
+		result = createIndex (file, filePath);
+		terminate (file);
+	}
+	return result;
+}
+
 extern tagResult tagsClose (tagFile *const file)
 {
 	tagResult result = TagFailure;
@@ -790,6 +1298,7 @@ static const char *TagFileName = "tags";
 static const char *ProgramName;
 static int extensionFields;
 static int SortOverride;
+static int MapFile;
 static sortType SortMethod;
 
 static void printTag (const tagEntry *entry)
@@ -824,7 +1333,8 @@ static void findTag (const char *const name, const int options)
 {
 	tagFileInfo info;
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
+	tagFile *const file = MapFile ?
+		tagsOpenMapped (TagFileName, &info) : tagsOpen (TagFileName, &info);
 	if (file == NULL)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
@@ -846,11 +1356,22 @@ static void findTag (const char *const name, const int options)
 	}
 }
 
+static void indexTagFile (void)
+{
+	if (tagsCreateIndex (TagFileName) != TagSuccess)
+	{
+		fprintf (stderr, "%s: cannot create index of tag file: %s\n",
+				ProgramName, TagFileName);
+		exit (1);
+	}
+}
+
 static void listTags (void)
 {
 	tagFileInfo info;
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
+	tagFile *const file = MapFile ?
+		tagsOpenMapped (TagFileName, &info) : tagsOpen (TagFileName, &info);
 	if (file == NULL)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
@@ -867,11 +1388,13 @@ static void listTags (void)
 
 const char *const Usage =
 	"Find tag file entries matching specified names.\n\n"
-	"Usage: %s [-ilp] [-s[0|1]] [-t file] [name(s)]\n\n"
+	"Usage: %s [-ilmpx] [-s[0|1]] [-t file] [name(s)]\n\n"
 	"Options:\n"
 	"    -e           Include extension fields in output.\n"
 	"    -i           Perform case-insensitive matching.\n"
+	"    -x           Create an index of the tag file for faster lookups.\n"
 	"    -l           List all tags.\n"
+	"    -m           Map tag file into memory when opening it.\n"
 	"    -p           Perform partial matching.\n"
 	"    -s[0|1|2]    Override sort detection of tag file.\n"
 	"    -t file      Use specified tag file (default: \"tags\").\n"
@@ -907,6 +1430,8 @@ extern int main (int argc, char **argv)
 					case 'i': options |= TAG_IGNORECASE;   break;
 					case 'p': options |= TAG_PARTIALMATCH; break;
 					case 'l': listTags (); actionSupplied = 1; break;
+					case 'm': MapFile = 1;                 break;
+					case 'x': indexTagFile (); actionSupplied = 1; break;
 			
 					case 't':
 						if (arg [j+1] != '\0')
@@ -157,6 +157,18 @@ typedef struct {
 */
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info);
 
+/*
+*  This function behaves exactly like tagsOpen(), except that the whole tag
+*  file (and its index, if any) is mapped into memory where the system
+*  supports it. Lookups and steps through the file then examine the mapping
+*  directly instead of reading and copying every line they pass over; only a
+*  matching line is copied, so that the fields of the returned entry are still
+*  null-terminated strings valid until the next call for the same handle. The
+*  tag file must not be rewritten in place while it is open this way. Where
+*  memory mapping is unavailable, the file is simply read as by tagsOpen().
+*/
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info);
+
 /*
 *  This function allows the client to override the normal automatic detection
 *  of how a tag file is sorted. Permissible values for `type' are
@@ -216,7 +228,8 @@ extern const char *tagsField (const tagEntry *const entry, const char *const key
 *
 *    TAG_IGNORECASE
 *        Matching will be performed in a case-insenstive manner. Note that
-*        this disables binary searches of the tag file.
+*        this disables binary searches of the tag file, unless it has an
+*        index (see tagsCreateIndex()).
 *
 *    TAG_OBSERVECASE
 *        Matching will be performed in a case-senstive manner. Note that
@@ -236,6 +249,18 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry, const cha
 */
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 
+/*
+*  Create an index of the tag file found at `filePath', written next to it in
+*  a file of the same name with ".idx" appended. As long as the tag file is
+*  not modified afterwards, tagsOpen() will use the index and tagsFind() and
+*  tagsFindNext() will then locate tags through it, in time logarithmic in the
+*  number of tags, whether or not the tag file is sorted and whether or not
+*  case is ignored. Matching tags are then returned ordered by name (with
+*  case folded if ignored), then by position in the tag file. The function
+*  will return TagSuccess if the index was written, TagFailure if not.
+*/
+extern tagResult tagsCreateIndex (const char *const filePath);
+
 /*
 *  Call tagsTerminate() at completion of reading the tag file, which will
 *  close the file and free any internal memory allocated. The function will
@@ -415,39 +415,77 @@ static boolean isAmigaDirectory (const char *const name)
 #endif
 
 /* For caching of stat() calls */
+static fileStatus CachedStatus;
+
+static void setFileStatus (
+		fileStatus *const file, const boolean isSymbolicLink,
+		const struct stat *const status)
+{
+	file->exists = TRUE;
+	file->isSymbolicLink = isSymbolicLink;
+#ifdef AMIGA
+	file->isDirectory = isAmigaDirectory (file->name);
+#else
+	file->isDirectory = (boolean) S_ISDIR (status->st_mode);
+#endif
+	file->isNormalFile = (boolean) (S_ISREG (status->st_mode));
+	file->isExecutable = (boolean) ((status->st_mode &
+		(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
+	file->isSetuid = (boolean) ((status->st_mode & S_ISUID) != 0);
+	file->size = status->st_size;
+	file->mtime = (unsigned long) status->st_mtime;
+}
+
 extern fileStatus *eStat (const char *const fileName)
 {
 	struct stat status;
-	static fileStatus file;
-	if (file.name == NULL  ||  strcmp (fileName, file.name) != 0)
+	fileStatus *const file = &CachedStatus;
+	if (file->name == NULL  ||  strcmp (fileName, file->name) != 0)
 	{
-		eStatFree (&file);
-		file.name = eStrdup (fileName);
-		if (lstat (file.name, &status) != 0)
-			file.exists = FALSE;
-		else
+		eStatFree (file);
+		file->name = eStrdup (fileName);
+		file->exists = FALSE;
+		file->isSymbolicLink = FALSE;
+		if (lstat (file->name, &status) == 0)
 		{
-			file.isSymbolicLink = (boolean) S_ISLNK (status.st_mode);
-			if (file.isSymbolicLink  &&  stat (file.name, &status) != 0)
-				file.exists = FALSE;
+			const boolean isLink = (boolean) S_ISLNK (status.st_mode);
+			if (! isLink  ||  stat (file->name, &status) == 0)
+				setFileStatus (file, isLink, &status);
 			else
-			{
-				file.exists = TRUE;
-#ifdef AMIGA
-				file.isDirectory = isAmigaDirectory (file.name);
-#else
-				file.isDirectory = (boolean) S_ISDIR (status.st_mode);
-#endif
-				file.isNormalFile = (boolean) (S_ISREG (status.st_mode));
-				file.isExecutable = (boolean) ((status.st_mode &
-					(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
-				file.isSetuid = (boolean) ((status.st_mode & S_ISUID) != 0);
-				file.size = status.st_size;
-			}
+				file->isSymbolicLink = TRUE;
+		}
+	}
+	return file;
+}
+
+#ifdef HAVE_FSTATAT
+/*  Like eStat (), for the file `entryName' of the directory open as `dirFd'
+ *  and known as `fileName', which saves resolving the whole path again.
+ */
+extern fileStatus *eStatAt (
+		const int dirFd, const char *const entryName,
+		const char *const fileName)
+{
+	struct stat status;
+	fileStatus *const file = &CachedStatus;
+	if (file->name == NULL  ||  strcmp (fileName, file->name) != 0)
+	{
+		eStatFree (file);
+		file->name = eStrdup (fileName);
+		file->exists = FALSE;
+		file->isSymbolicLink = FALSE;
+		if (fstatat (dirFd, entryName, &status, AT_SYMLINK_NOFOLLOW) == 0)
+		{
+			const boolean isLink = (boolean) S_ISLNK (status.st_mode);
+			if (! isLink  ||  fstatat (dirFd, entryName, &status, 0) == 0)
+				setFileStatus (file, isLink, &status);
+			else
+				file->isSymbolicLink = TRUE;
 		}
 	}
-	return &file;
+	return file;
 }
+#endif
 
 extern void eStatFree (fileStatus *status)
 {
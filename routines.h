@@ -76,6 +76,9 @@ typedef struct {
 
 		/* Size of file (pointed to) */
 	unsigned long size;
+
+		/* Time of last modification of file (pointed to) */
+	unsigned long mtime;
 } fileStatus; 
 
 /*
@@ -112,6 +115,9 @@ extern char* newUpperString (const char* str);
 /* File system functions */
 extern void setCurrentDirectory (void);
 extern fileStatus *eStat (const char *const fileName);
+#ifdef HAVE_FSTATAT
+extern fileStatus *eStatAt (const int dirFd, const char *const entryName, const char *const fileName);
+#endif
 extern void eStatFree (fileStatus *status);
 extern boolean doesFileExist (const char *const fileName);
 extern boolean isRecursiveLink (const char* const dirName);
@@ -19,6 +19,7 @@
 #endif
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>  /* to declare toupper () */
 
 #include "debug.h"
 #include "entry.h"
@@ -45,6 +46,327 @@ extern void catFile (const char *const name)
 	}
 }
 
+/*
+ *  These functions sort tag lines held in memory, and provide the internal
+ *  sort. The tag file is read into a single buffer, in chunks no larger than
+ *  SORT_BUFFER_SIZE, and the lines of each chunk are ordered by a stable merge
+ *  sort over an index into it. A tag file which fits into one chunk is written
+ *  back directly; otherwise each sorted chunk is spilled to a temporary file
+ *  and the runs are merged. Tags collected in memory for standard output are
+ *  spilled and merged the same way. Identical lines are dropped while
+ *  writing, as "sort -u" would.
+ */
+
+typedef struct sSortLine {
+	const char *line;
+	size_t length;  /* excluding newline */
+} sortLine;
+
+typedef int (*sortCompareFunc) (const sortLine *const, const sortLine *const);
+
+/*  A sorted run spilled to a temporary file, and its current line.
+ */
+typedef struct sSortRun {
+	FILE *fp;
+	char *name;
+	vString *vLine;
+	sortLine current;
+} sortRun;
+
+/*
+*   DATA DEFINITIONS
+*/
+static sortRun *Runs = NULL;
+static unsigned int NumRuns = 0;
+
+static void failedSort (FILE *const fp, const char* msg)
+{
+	const char* const cannotSort = "cannot sort tag file";
+	if (fp != NULL)
+		fclose (fp);
+	if (msg == NULL)
+		error (FATAL | PERROR, "%s", cannotSort);
+	else
+		error (FATAL, "%s: %s", msg, cannotSort);
+}
+
+static int compareTags (const sortLine *const one, const sortLine *const two)
+{
+	const size_t length = one->length < two->length ? one->length : two->length;
+	int result = memcmp (one->line, two->line, length);
+
+	if (result == 0  &&  one->length != two->length)
+		result = one->length < two->length ? -1 : 1;
+	return result;
+}
+
+static int compareTagsFolded (const sortLine *const one, const sortLine *const two)
+{
+	const unsigned char *const s1 = (const unsigned char *) one->line;
+	const unsigned char *const s2 = (const unsigned char *) two->line;
+	const size_t length = one->length < two->length ? one->length : two->length;
+	int result = 0;
+	size_t i;
+
+	for (i = 0  ;  result == 0  &&  i < length  ;  ++i)
+		result = toupper ((int) s1 [i]) - toupper ((int) s2 [i]);
+	if (result == 0  &&  one->length != two->length)
+		result = one->length < two->length ? -1 : 1;
+	/*  Order lines differing only in case consistently, so that identical
+	 *  lines end up next to each other.
+	 */
+	if (result == 0)
+		result = compareTags (one, two);
+	return result;
+}
+
+static void mergeSortLines (
+		sortLine *const lines, sortLine *const scratch, const size_t count,
+		const sortCompareFunc compare)
+{
+	if (count > 1)
+	{
+		const size_t half = count / 2;
+		size_t i = 0, j = half, k = 0;
+
+		mergeSortLines (lines, scratch, half, compare);
+		mergeSortLines (lines + half, scratch, count - half, compare);
+		if (compare (&lines [half - 1], &lines [half]) <= 0)
+			return;  /* already in order */
+
+		memcpy (scratch, lines, half * sizeof (sortLine));
+		while (i < half  &&  j < count)
+		{
+			if (compare (&lines [j], &scratch [i]) < 0)
+				lines [k++] = lines [j++];
+			else
+				lines [k++] = scratch [i++];
+		}
+		while (i < half)
+			lines [k++] = scratch [i++];
+	}
+}
+
+/*  Writes a line unless it is identical to the one last written.
+ */
+static void writeSortedLine (
+		const sortLine *const line, vString *const previous,
+		boolean *const first, FILE *const fp)
+{
+	if (! *first  &&
+		vStringLength (previous) == line->length  &&
+		memcmp (vStringValue (previous), line->line, line->length) == 0)
+		return;
+	vStringClear (previous);
+	vStringNCatSUnsafe (previous, line->line, line->length);
+	*first = FALSE;
+	if (fwrite (line->line, (size_t) 1, line->length, fp) < line->length  ||
+		putc ('\n', fp) == EOF)
+		failedSort (fp, NULL);
+}
+
+/*  Indexes the lines of the first `filled' bytes of `buffer', growing `lines'
+ *  as needed, and returns their number. Unless `atEnd' is set, a trailing
+ *  partial line is left out; where it starts is stored in `start'.
+ */
+static size_t indexLines (
+		const char *const buffer, const size_t filled, const boolean atEnd,
+		sortLine **const lines, size_t *const maxLines, size_t *const start)
+{
+	size_t numLines = 0;
+	size_t i;
+
+	*start = 0;
+	for (i = 0  ;  i < filled  ;  ++i)
+	{
+		if (buffer [i] == '\n'  ||  (atEnd  &&  i == filled - 1))
+		{
+			if (numLines == *maxLines)
+			{
+				*maxLines = (*maxLines == 0) ? 1024 : *maxLines * 2;
+				*lines = xRealloc (*lines, *maxLines, sortLine);
+			}
+			(*lines) [numLines].line = buffer + *start;
+			(*lines) [numLines].length =
+					(buffer [i] == '\n') ? i - *start : i + 1 - *start;
+			++numLines;
+			*start = i + 1;
+		}
+	}
+	return numLines;
+}
+
+static void writeSortedLines (
+		const sortLine *const lines, const size_t numLines, FILE *const fp)
+{
+	vString *const previous = vStringNew ();
+	boolean first = TRUE;
+	size_t i;
+
+	for (i = 0  ;  i < numLines  ;  ++i)
+		writeSortedLine (&lines [i], previous, &first, fp);
+	vStringDelete (previous);
+}
+
+static sortCompareFunc sortCompare (void)
+{
+	return Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
+}
+
+/*  Reads the next line of a run, returning FALSE at its end.
+ */
+static boolean readRunLine (sortRun *const run)
+{
+	char buffer [1024];
+	boolean found = FALSE;
+
+	vStringClear (run->vLine);
+	while (fgets (buffer, (int) sizeof (buffer), run->fp) != NULL)
+	{
+		const size_t length = strlen (buffer);
+
+		found = TRUE;
+		if (length > 0  &&  buffer [length - 1] == '\n')
+		{
+			vStringNCatSUnsafe (run->vLine, buffer, length - 1);
+			break;
+		}
+		vStringNCatSUnsafe (run->vLine, buffer, length);
+	}
+	if (! found  &&  ferror (run->fp))
+		failedSort (NULL, NULL);
+	run->current.line = vStringValue (run->vLine);
+	run->current.length = vStringLength (run->vLine);
+	return found;
+}
+
+/*  Writes sorted lines into a new run, to be merged by mergeSortedRuns ().
+ */
+static void addSortedRun (const sortLine *const lines, const size_t numLines)
+{
+	sortRun *run;
+
+	Runs = xRealloc (Runs, NumRuns + 1, sortRun);
+	run = &Runs [NumRuns++];
+	run->name = NULL;
+	run->fp = tempFile ("w+b", &run->name);
+	run->vLine = vStringNew ();
+	verbose ("sorting run %u of tag file into %s\n", NumRuns, run->name);
+	writeSortedLines (lines, numLines, run->fp);
+	if (fflush (run->fp) != 0)
+		failedSort (NULL, NULL);
+}
+
+static void closeRun (sortRun *const run)
+{
+	fclose (run->fp);
+	remove (run->name);
+	eFree (run->name);
+	vStringDelete (run->vLine);
+}
+
+/*  Merges all the runs written so far into `fp', then discards them.
+ */
+static void mergeSortedRuns (FILE *const fp)
+{
+	const sortCompareFunc compare = sortCompare ();
+	vString *const previous = vStringNew ();
+	boolean first = TRUE;
+	unsigned int live = 0;
+	unsigned int i;
+
+	for (i = 0  ;  i < NumRuns  ;  ++i)
+	{
+		rewind (Runs [i].fp);
+		if (readRunLine (&Runs [i]))
+			Runs [live++] = Runs [i];
+		else
+			closeRun (&Runs [i]);
+	}
+	while (live > 0)
+	{
+		/*  Earlier runs win ties, which keeps the merge stable.
+		 */
+		unsigned int best = 0;
+		for (i = 1  ;  i < live  ;  ++i)
+			if (compare (&Runs [i].current, &Runs [best].current) < 0)
+				best = i;
+		writeSortedLine (&Runs [best].current, previous, &first, fp);
+		if (! readRunLine (&Runs [best]))
+		{
+			closeRun (&Runs [best]);
+			--live;
+			for (i = best  ;  i < live  ;  ++i)
+				Runs [i] = Runs [i + 1];
+		}
+	}
+	vStringDelete (previous);
+	eFree (Runs);
+	Runs = NULL;
+	NumRuns = 0;
+}
+
+/*  Indexes and sorts the `length' bytes of tag lines in `buffer', returning
+ *  the number of lines and storing their index, to be freed, in `lines'.
+ */
+static size_t sortBuffer (
+		const char *const buffer, const size_t length, sortLine **const lines)
+{
+	size_t maxLines = 0;
+	size_t start;
+	const size_t numLines =
+			indexLines (buffer, length, TRUE, lines, &maxLines, &start);
+
+	if (numLines > 0)
+	{
+		sortLine *const scratch = xMalloc (numLines / 2 + 1, sortLine);
+
+		mergeSortLines (*lines, scratch, numLines, sortCompare ());
+		eFree (scratch);
+	}
+	return numLines;
+}
+
+/*  Sorts the tag lines held in `buffer' into a run of their own, so that the
+ *  buffer can be reused. Used for tags collected in memory when they grow too
+ *  large, whichever kind of sort is configured.
+ */
+extern void spillSortedTags (const char *const buffer, const size_t length)
+{
+	sortLine *lines = NULL;
+	const size_t numLines = sortBuffer (buffer, length, &lines);
+
+	if (numLines > 0)
+	{
+		addSortedRun (lines, numLines);
+		eFree (lines);
+	}
+}
+
+/*  Writes to `fp' the tag lines held in `buffer' together with those of any
+ *  runs spilled before, sorted and without duplicates.
+ */
+extern void writeSortedTags (
+		const char *const buffer, const size_t length, FILE *const fp)
+{
+	if (NumRuns > 0)
+	{
+		spillSortedTags (buffer, length);
+		mergeSortedRuns (fp);
+	}
+	else
+	{
+		sortLine *lines = NULL;
+		const size_t numLines = sortBuffer (buffer, length, &lines);
+
+		if (numLines > 0)
+		{
+			writeSortedLines (lines, numLines, fp);
+			eFree (lines);
+		}
+	}
+}
+
 #ifdef EXTERNAL_SORT
 
 #ifdef NON_CONST_PUTENV_PROTOTYPE
@@ -97,132 +419,117 @@ extern void externalSortTags (const boolean toStdout)
 
 #else
 
-/*
- *  These functions provide a basic internal sort. No great memory
- *  optimization is performed (e.g. recursive subdivided sorts),
- *  so have lots of memory if you have large tag files.
- */
-
-static void failedSort (FILE *const fp, const char* msg)
-{
-	const char* const cannotSort = "cannot sort tag file";
-	if (fp != NULL)
-		fclose (fp);
-	if (msg == NULL)
-		error (FATAL | PERROR, "%s", cannotSort);
-	else
-		error (FATAL, "%s: %s", msg, cannotSort);
-}
-
-static int compareTagsFolded(const void *const one, const void *const two)
-{
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
-
-	return struppercmp (line1, line2);
-}
-
-static int compareTags (const void *const one, const void *const two)
+static FILE *openSortOutput (const boolean toStdout)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	FILE *fp = stdout;
 
-	return strcmp (line1, line2);
-}
-
-static void writeSortedTags (
-		char **const table, const size_t numTags, const boolean toStdout)
-{
-	FILE *fp;
-	size_t i;
-
-	/*  Write the sorted lines back into the tag file.
-	 */
-	if (toStdout)
-		fp = stdout;
-	else
+	if (! toStdout)
 	{
 		fp = fopen (tagFileName (), "w");
 		if (fp == NULL)
 			failedSort (fp, NULL);
 	}
-	for (i = 0 ; i < numTags ; ++i)
-	{
-		/*  Here we filter out identical tag *lines* (including search
-		 *  pattern) if this is not an xref file.
-		 */
-		if (i == 0  ||  Option.xref  ||  strcmp (table [i], table [i-1]) != 0)
-			if (fputs (table [i], fp) == EOF)
-				failedSort (fp, NULL);
-	}
+	return fp;
+}
+
+static void closeSortOutput (FILE *const fp, const boolean toStdout)
+{
 	if (toStdout)
 		fflush (fp);
-	else
-		fclose (fp);
+	else if (fclose (fp) != 0)
+		failedSort (NULL, NULL);
 }
 
 extern void internalSortTags (const boolean toStdout)
 {
-	vString *vLine = vStringNew ();
-	FILE *fp = NULL;
-	const char *line;
-	size_t i;
-	int (*cmpFunc)(const void *, const void *);
-
-	/*  Allocate a table of line pointers to be sorted.
-	 */
-	size_t numTags = TagFile.numTags.added + TagFile.numTags.prev;
-	const size_t tableSize = numTags * sizeof (char *);
-	char **const table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
-
-
-	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
-	if (table == NULL)
-		failedSort (fp, "out of memory");
+	const sortCompareFunc compare = sortCompare ();
+	size_t bufferSize = SORT_BUFFER_SIZE;
+	char *buffer;
+	size_t filled = 0;
+	size_t maxLines = 0;
+	sortLine *lines = NULL;
+	sortLine *scratch = NULL;
+	boolean atEnd = FALSE;
+	FILE *const fp = fopen (tagFileName (), "rb");
 
-	/*  Open the tag file and place its lines into allocated buffers.
-	 */
-	fp = fopen (tagFileName (), "r");
 	if (fp == NULL)
 		failedSort (fp, NULL);
-	for (i = 0  ;  i < numTags  &&  ! feof (fp)  ;  )
+	else if (fseek (fp, 0L, SEEK_END) == 0)
+	{
+		/*  A tag file smaller than the buffer is read into one byte more
+		 *  than it holds, so that its end is seen on the first read.
+		 */
+		const long size = ftell (fp);
+
+		if (size >= 0  &&  (unsigned long) size < (unsigned long) SORT_BUFFER_SIZE)
+			bufferSize = (size_t) size + 1;
+	}
+	rewind (fp);
+	buffer = xMalloc (bufferSize, char);
+	while (! atEnd)
 	{
-		line = readLine (vLine, fp);
-		if (line == NULL)
+		size_t numLines;
+		size_t start;
+		size_t numRead;
+
+		/*  Fill the buffer, growing it only if a single line does not fit.
+		 */
+		if (filled == bufferSize)
+		{
+			bufferSize *= 2;
+			buffer = xRealloc (buffer, bufferSize, char);
+		}
+		numRead = fread (buffer + filled, (size_t) 1, bufferSize - filled, fp);
+		if (numRead < bufferSize - filled)
 		{
-			if (! feof (fp))
+			if (ferror (fp))
 				failedSort (fp, NULL);
-			break;
+			atEnd = TRUE;
+		}
+		filled += numRead;
+
+		numLines = indexLines (buffer, filled, atEnd, &lines, &maxLines, &start);
+		if (numLines == 0  &&  ! atEnd)
+			continue;  /* line longer than the buffer */
+
+		scratch = xRealloc (scratch, maxLines / 2 + 1, sortLine);
+		mergeSortLines (lines, scratch, numLines, compare);
+
+		if (atEnd  &&  NumRuns == 0)
+		{
+			/*  Everything fit in memory: write the result directly.
+			 */
+			FILE *const out = openSortOutput (toStdout);
+
+			fclose (fp);
+			writeSortedLines (lines, numLines, out);
+			closeSortOutput (out, toStdout);
 		}
-		else if (*line == '\0'  ||  strcmp (line, "\n") == 0)
-			;  /* ignore blank lines */
 		else
 		{
-			const size_t stringSize = strlen (line) + 1;
-
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (fp, "out of memory");
-			DebugStatement ( mallocSize += stringSize; )
-			strcpy (table [i], line);
-			++i;
+			addSortedRun (lines, numLines);
+
+			/*  Carry the trailing partial line over to the next chunk.
+			 */
+			memmove (buffer, buffer + start, filled - start);
+			filled -= start;
 		}
 	}
-	numTags = i;
-	fclose (fp);
-	vStringDelete (vLine);
-
-	/*  Sort the lines.
-	 */
-	qsort (table, numTags, sizeof (*table), cmpFunc);
-
-	writeSortedTags (table, numTags, toStdout);
+	if (NumRuns > 0)
+	{
+		FILE *const out = openSortOutput (toStdout);
 
-	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
-	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
-	free (table);
+		fclose (fp);
+		mergeSortedRuns (out);
+		closeSortOutput (out, toStdout);
+	}
+	PrintStatus (("sort memory: %ld bytes\n", (long) (bufferSize +
+			(maxLines + maxLines / 2 + 1) * sizeof (sortLine))));
+	if (lines != NULL)
+		eFree (lines);
+	if (scratch != NULL)
+		eFree (scratch);
+	eFree (buffer);
 }
 
 #endif
@@ -16,10 +16,24 @@
 */
 #include "general.h"  /* must always come first */
 
+#include <stdio.h>  /* to declare FILE */
+
+/*
+*   MACROS
+*/
+
+/*  Amount of tag lines sorted in memory at once before spilling a run.
+ */
+#ifndef SORT_BUFFER_SIZE
+# define SORT_BUFFER_SIZE  (64L * 1024L * 1024L)
+#endif
+
 /*
 *   FUNCTION PROTOTYPES
 */
 extern void catFile (const char *const name);
+extern void spillSortedTags (const char *const buffer, const size_t length);
+extern void writeSortedTags (const char *const buffer, const size_t length, FILE *const fp);
 
 #ifdef EXTERNAL_SORT
 extern void externalSortTags (const boolean toStdout);
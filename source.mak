@@ -3,9 +3,9 @@
 # Shared macros
 
 HEADERS = \
-	args.h ctags.h debug.h entry.h general.h get.h keyword.h \
-	main.h options.h parse.h parsers.h read.h routines.h sort.h \
-	strlist.h vstring.h
+	args.h ctags.h debug.h entry.h general.h get.h gitindex.h ignorefile.h \
+	keyword.h main.h manifest.h options.h parse.h parsers.h read.h \
+	routines.h sort.h strlist.h vstring.h
 
 SOURCES = \
 	args.c \
@@ -26,8 +26,10 @@ SOURCES = \
 	flex.c \
 	fortran.c \
 	get.c \
+	gitindex.c \
 	go.c \
 	html.c \
+	ignorefile.c \
 	jscript.c \
 	keyword.c \
 	lisp.c \
@@ -35,6 +37,7 @@ SOURCES = \
 	lua.c \
 	main.c \
 	make.c \
+	manifest.c \
 	objc.c \
 	ocaml.c \
 	options.c \
@@ -91,8 +94,10 @@ OBJECTS = \
 	flex.$(OBJEXT) \
 	fortran.$(OBJEXT) \
 	get.$(OBJEXT) \
+	gitindex.$(OBJEXT) \
 	go.$(OBJEXT) \
 	html.$(OBJEXT) \
+	ignorefile.$(OBJEXT) \
 	jscript.$(OBJEXT) \
 	keyword.$(OBJEXT) \
 	lisp.$(OBJEXT) \
@@ -100,6 +105,7 @@ OBJECTS = \
 	lua.$(OBJEXT) \
 	main.$(OBJEXT) \
 	make.$(OBJEXT) \
+	manifest.$(OBJEXT) \
 	objc.$(OBJEXT) \
 	ocaml.$(OBJEXT) \
 	options.$(OBJEXT) \
@@ -15,6 +15,7 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <ctype.h>  /* to define tolower () */
 #ifdef HAVE_FNMATCH_H
 # include <fnmatch.h>
 #endif
@@ -24,6 +25,44 @@
 #include "routines.h"
 #include "strlist.h"
 
+/*
+*   MACROS
+*/
+/*  Without fnmatch (), patterns are file names compared as the file system
+ *  compares them. */
+#if ! defined (HAVE_FNMATCH)  &&  defined (CASE_INSENSITIVE_FILENAMES)
+# define MATCH_FOLDED
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+
+typedef struct sMatchEntry {
+	const char *string;  /* points into the compiled list */
+	size_t length;
+	struct sMatchEntry *next;
+} matchEntry;
+
+/*  Set of strings, together with the distinct lengths of its strings.
+ */
+typedef struct sMatchTable {
+	matchEntry **buckets;
+	matchEntry *entries;
+	unsigned int size;   /* number of buckets, a power of 2 */
+	unsigned int count;
+	size_t *lengths;
+	unsigned int lengthCount;
+} matchTable;
+
+struct sFileMatcher {
+	matchTable names;     /* patterns matching a single file name */
+	matchTable suffixes;  /* literal suffixes of patterns "*suffix" */
+	matchTable prefixes;  /* literal prefixes of patterns "prefix*" */
+	const char **globs;   /* all other patterns */
+	unsigned int globCount;
+};
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -270,6 +309,195 @@ extern boolean stringListFileMatched (
 	return result;
 }
 
+/*
+*   File name matchers
+*/
+
+static unsigned long hashMatchString (const char *const string, const size_t length)
+{
+	unsigned long hash = 2166136261UL;
+	size_t i;
+
+	for (i = 0  ;  i < length  ;  ++i)
+	{
+#ifdef MATCH_FOLDED
+		const int c = tolower ((unsigned char) string [i]);
+#else
+		const int c = (unsigned char) string [i];
+#endif
+		hash = ((hash ^ (unsigned long) c) * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
+
+static boolean isInMatchTable (
+		const matchTable *const table, const char *const string,
+		const size_t length)
+{
+	boolean result = FALSE;
+
+	if (table->count > 0)
+	{
+		const unsigned long hash = hashMatchString (string, length);
+		const matchEntry *entry = table->buckets [hash & (table->size - 1)];
+
+		for (  ;  entry != NULL  &&  ! result  ;  entry = entry->next)
+		{
+			if (entry->length == length)
+#ifdef MATCH_FOLDED
+				result = (boolean) (strncasecmp (entry->string, string, length) == 0);
+#else
+				result = (boolean) (memcmp (entry->string, string, length) == 0);
+#endif
+		}
+	}
+	return result;
+}
+
+static void initMatchTable (matchTable *const table, const unsigned int maxCount)
+{
+	unsigned int size = 16;
+
+	while (size < 2 * maxCount)
+		size *= 2;
+	table->buckets = xCalloc (size, matchEntry*);
+	table->entries = (maxCount == 0) ? NULL : xMalloc (maxCount, matchEntry);
+	table->size = size;
+	table->count = 0;
+	table->lengths = (maxCount == 0) ? NULL : xMalloc (maxCount, size_t);
+	table->lengthCount = 0;
+}
+
+static void addToMatchTable (
+		matchTable *const table, const char *const string, const size_t length)
+{
+	if (! isInMatchTable (table, string, length))
+	{
+		const unsigned long hash = hashMatchString (string, length);
+		matchEntry *const entry = &table->entries [table->count++];
+		matchEntry **const bucket = &table->buckets [hash & (table->size - 1)];
+		unsigned int i;
+
+		entry->string = string;
+		entry->length = length;
+		entry->next = *bucket;
+		*bucket = entry;
+
+		for (i = 0  ;  i < table->lengthCount  ;  ++i)
+			if (table->lengths [i] == length)
+				break;
+		if (i == table->lengthCount)
+			table->lengths [table->lengthCount++] = length;
+	}
+}
+
+static void freeMatchTable (matchTable *const table)
+{
+	if (table->buckets != NULL)
+		eFree (table->buckets);
+	if (table->entries != NULL)
+		eFree (table->entries);
+	if (table->lengths != NULL)
+		eFree (table->lengths);
+}
+
+static boolean isGlobCharacter (const int c)
+{
+#ifdef HAVE_FNMATCH
+	return (boolean) (c != '\0'  &&  strchr ("*?[\\", c) != NULL);
+#else
+	return FALSE;
+#endif
+}
+
+static boolean hasGlobCharacter (const char *const string, const size_t length)
+{
+	boolean result = FALSE;
+	size_t i;
+	for (i = 0  ;  i < length  &&  ! result  ;  ++i)
+		result = isGlobCharacter (string [i]);
+	return result;
+}
+
+/*  Compiles the file name patterns of `list' into a matcher equivalent to
+ *  stringListFileMatched (), which remains valid as long as `list' is neither
+ *  modified nor deleted. Patterns which are a literal file name, a literal
+ *  suffix or a literal prefix are looked up in hash tables, so that matching
+ *  a file name does not depend upon their number; only the other patterns
+ *  are tried one after the other.
+ */
+extern fileMatcher* fileMatcherNew (const stringList* const list)
+{
+	fileMatcher* const result = xMalloc (1, fileMatcher);
+	const unsigned int count = stringListCount (list);
+	unsigned int i;
+
+	initMatchTable (&result->names, count);
+	initMatchTable (&result->suffixes, count);
+	initMatchTable (&result->prefixes, count);
+	result->globs = (count == 0) ? NULL : xMalloc (count, const char*);
+	result->globCount = 0;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const vString* const item = stringListItem (list, i);
+		const char* const pattern = vStringValue (item);
+		const size_t length = vStringLength (item);
+
+		if (! hasGlobCharacter (pattern, length))
+			addToMatchTable (&result->names, pattern, length);
+		else if (pattern [0] == '*'  &&
+				! hasGlobCharacter (pattern + 1, length - 1))
+			addToMatchTable (&result->suffixes, pattern + 1, length - 1);
+		else if (pattern [length - 1] == '*'  &&
+				! hasGlobCharacter (pattern, length - 1))
+			addToMatchTable (&result->prefixes, pattern, length - 1);
+		else
+			result->globs [result->globCount++] = pattern;
+	}
+	return result;
+}
+
+extern boolean fileMatcherMatched (
+		const fileMatcher* const matcher, const char* const fileName)
+{
+	const size_t length = strlen (fileName);
+	boolean result = isInMatchTable (&matcher->names, fileName, length);
+	unsigned int i;
+
+	for (i = 0  ;  ! result  &&  i < matcher->suffixes.lengthCount  ;  ++i)
+	{
+		const size_t suffixLength = matcher->suffixes.lengths [i];
+		if (suffixLength <= length)
+			result = isInMatchTable (&matcher->suffixes,
+					fileName + length - suffixLength, suffixLength);
+	}
+	for (i = 0  ;  ! result  &&  i < matcher->prefixes.lengthCount  ;  ++i)
+	{
+		const size_t prefixLength = matcher->prefixes.lengths [i];
+		if (prefixLength <= length)
+			result = isInMatchTable (&matcher->prefixes, fileName, prefixLength);
+	}
+#ifdef HAVE_FNMATCH
+	for (i = 0  ;  ! result  &&  i < matcher->globCount  ;  ++i)
+		result = (boolean) (fnmatch (matcher->globs [i], fileName, 0) == 0);
+#endif
+	return result;
+}
+
+extern void fileMatcherDelete (fileMatcher* const matcher)
+{
+	if (matcher != NULL)
+	{
+		freeMatchTable (&matcher->names);
+		freeMatchTable (&matcher->suffixes);
+		freeMatchTable (&matcher->prefixes);
+		if (matcher->globs != NULL)
+			eFree (matcher->globs);
+		eFree (matcher);
+	}
+}
+
 extern void stringListPrint (const stringList *const current)
 {
 	unsigned int i;
@@ -27,6 +27,8 @@ typedef struct sStringList {
 	vString    **list;
 } stringList;
 
+typedef struct sFileMatcher fileMatcher;
+
 /*
 *   FUNCTION PROTOTYPES
 */
@@ -47,6 +49,9 @@ extern boolean stringListHasTest (const stringList *const current, boolean (*tes
 extern boolean stringListRemoveExtension (stringList* const current, const char* const extension);
 extern boolean stringListExtensionMatched (const stringList* const list, const char* const extension);
 extern boolean stringListFileMatched (const stringList* const list, const char* const str);
+extern fileMatcher* fileMatcherNew (const stringList* const list);
+extern boolean fileMatcherMatched (const fileMatcher* const matcher, const char* const fileName);
+extern void fileMatcherDelete (fileMatcher* const matcher);
 extern void stringListPrint (const stringList *const current);
 
 #endif  /* _STRLIST_H */
@@ -6,6 +6,7 @@
 #	Requires GNU make.
 
 CTAGS_TEST = ./ctags
+READTAGS_TEST = ./readtags
 CTAGS_REF = ./ctags.ref
 TEST_OPTIONS = -nu --c-kinds=+lpx
 
@@ -95,8 +96,8 @@ test.linux: $(CTAGS_TEST) $(CTAGS_REF)
 endif
 
 
-UNITS_ARTIFACTS=Units/*.d/EXPECTED.TMP Units/*.d/OUTPUT.TMP Units/*.d/DIFF.TMP
-test.units: $(CTAGS_TEST)
+UNITS_ARTIFACTS=Units/*.d/EXPECTED.TMP Units/*.d/OUTPUT.TMP Units/*.d/DIFF.TMP Units/*.d/WORK.TMP
+test.units: $(CTAGS_TEST) $(READTAGS_TEST)
 	@ for input in Units/*.d/input.*; do \
 		t=$${input%/input.*}; \
 		name=$${t/.d/}; \
@@ -104,20 +105,30 @@ test.units: $(CTAGS_TEST)
 		expected="$$t"/expected; \
 		expectedtmp="$$t"/EXPECTED.TMP; \
 		args="$$t"/args; \
+		run="$$t"/run; \
 		filter="$$t"/filter; \
 		output="$$t"/OUTPUT.TMP; \
 		diff="$$t"/DIFF.TMP; \
+		work="$$t"/WORK.TMP; \
 		\
 		echo -n "Testing $${name}..."; \
 		\
-		$(CTAGS_TEST) -o - $$(test -f "$${args}" && cat "$$args") "$$input" |	\
+		rm -rf "$$work"; \
+		if test -x "$$run"; then \
+			CTAGS_TEST="$(CTAGS_TEST)" READTAGS_TEST="$(READTAGS_TEST)" \
+			WORK="$$work" \
+			"$$run" "$$input"; \
+		else \
+			$(CTAGS_TEST) -o - $$(test -f "$${args}" && cat "$$args") "$$input"; \
+		fi | \
 		if test -x "$$filter"; then "$$filter"; else cat; fi > "$${output}";	\
 		cp "$$expected" "$$expectedtmp"; \
 		$(call DIFF_BASE,"$$expectedtmp","$$output","$$diff"); \
+		test -f "$$diff" || rm -rf "$$work"; \
 	done
 
 TEST_ARTIFACTS = test.*.diff tags.ref tags.test $(UNITS_ARTIFACTS)
 clean-test:
-	rm -f $(TEST_ARTIFACTS)
+	rm -rf $(TEST_ARTIFACTS)
 
 # vi:ts=4 sw=4
@@ -63,6 +63,15 @@ extern void vStringClear (vString *const string)
 	DebugStatement ( memset (string->buffer, 0, string->size); )
 }
 
+/*  Shortens string to its first "length" characters.
+ */
+extern void vStringTruncate (vString *const string, const size_t length)
+{
+	Assert (length <= string->length);
+	string->length = length;
+	string->buffer [length] = '\0';
+}
+
 extern void vStringDelete (vString *const string)
 {
 	if (string != NULL)
@@ -143,6 +152,19 @@ extern void vStringNCatS (
 	vStringTerminate (string);
 }
 
+/*  Appends exactly "length" characters of "s", which need not be null
+ *  terminated, in a single copy.
+ */
+extern void vStringNCatSUnsafe (
+		vString *const string, const char *const s, const size_t length)
+{
+	while (string->length + length + 1 >= string->size)/*  check for buffer overflow */
+		vStringAutoResize (string);
+	memcpy (string->buffer + string->length, s, length);
+	string->length += length;
+	string->buffer [string->length] = '\0';
+}
+
 /*  Strip trailing newline from string.
  */
 extern void vStringStripNewline (vString *const string)
@@ -62,6 +62,7 @@ typedef struct sVString {
 */
 extern boolean vStringAutoResize (vString *const string);
 extern void vStringClear (vString *const string);
+extern void vStringTruncate (vString *const string, const size_t length);
 extern vString *vStringNew (void);
 extern void vStringDelete (vString *const string);
 #ifndef VSTRING_PUTC_MACRO
@@ -73,6 +74,7 @@ extern void vStringChop (vString *const string);
 extern void vStringStripTrailing (vString *const string);
 extern void vStringCatS (vString *const string, const char *const s);
 extern void vStringNCatS (vString *const string, const char *const s, const size_t length);
+extern void vStringNCatSUnsafe (vString *const string, const char *const s, const size_t length);
 extern vString *vStringNewCopy (const vString *const string);
 extern vString *vStringNewInit (const char *const s);
 extern void vStringCopyS (vString *const string, const char *const s);